@@ -0,0 +1,168 @@
+#include <Bytecode/Interpreter.h>
+
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+
+// Measures interpreter dispatch throughput on loop-heavy programs. Usage: WaffleBytecodeBench [scale]
+namespace
+{
+    using Bytecode::FunctionBuilder;
+    using Bytecode::Opcode;
+    using Bytecode::Type;
+    using Bytecode::Value;
+
+    struct Program
+    {
+        std::string name;
+        std::function<void(FunctionBuilder &)> build;
+        std::int64_t argument;
+    };
+
+    // sum += i for i in [0, n)
+    void SumLoop(FunctionBuilder &fn)
+    {
+        auto sum = fn.NewRegister();
+        auto i = fn.NewRegister();
+        auto head = fn.NewLabel();
+        auto done = fn.NewLabel();
+        fn.EmitLoad(sum, Value::From<std::int64_t>(0));
+        fn.EmitLoad(i, Value::From<std::int64_t>(0));
+        fn.Bind(head);
+        fn.EmitBranch(Opcode::BrGe_I64, i, fn.Param(0), done);
+        fn.Emit(Opcode::Add_I64, sum, sum, i);
+        fn.Emit(Opcode::AddImm_I64, i, i, 1);
+        fn.EmitJump(head);
+        fn.Bind(done);
+        fn.Emit(Opcode::Ret, sum);
+    }
+
+    // acc = acc * 31 + (i ^ j) on uint32, for i, j in [0, n)
+    void NestedLoops(FunctionBuilder &fn)
+    {
+        auto acc = fn.NewRegister();
+        auto i = fn.NewRegister();
+        auto j = fn.NewRegister();
+        auto k = fn.NewRegister();
+        auto t = fn.NewRegister();
+        auto outer = fn.NewLabel();
+        auto inner = fn.NewLabel();
+        auto next = fn.NewLabel();
+        auto done = fn.NewLabel();
+        fn.EmitLoad(acc, Value::From<std::uint32_t>(1));
+        fn.EmitLoad(k, Value::From<std::uint32_t>(31));
+        fn.EmitLoad(i, Value::From<std::uint32_t>(0));
+        fn.Bind(outer);
+        fn.EmitBranch(Opcode::BrGe_U32, i, fn.Param(0), done);
+        fn.EmitLoad(j, Value::From<std::uint32_t>(0));
+        fn.Bind(inner);
+        fn.EmitBranch(Opcode::BrGe_U32, j, fn.Param(0), next);
+        fn.Emit(Opcode::Xor_U32, t, i, j);
+        fn.Emit(Opcode::Mul_U32, acc, acc, k);
+        fn.Emit(Opcode::Add_U32, acc, acc, t);
+        fn.Emit(Opcode::AddImm_U32, j, j, 1);
+        fn.EmitJump(inner);
+        fn.Bind(next);
+        fn.Emit(Opcode::AddImm_U32, i, i, 1);
+        fn.EmitJump(outer);
+        fn.Bind(done);
+        fn.Emit(Opcode::Ret, acc);
+    }
+
+    // x = x * 0.5 + 1.0 on fp64, n times
+    void FloatLoop(FunctionBuilder &fn)
+    {
+        auto x = fn.NewRegister();
+        auto half = fn.NewRegister();
+        auto one = fn.NewRegister();
+        auto i = fn.NewRegister();
+        auto head = fn.NewLabel();
+        auto done = fn.NewLabel();
+        fn.EmitLoad(x, Value::From(0.0));
+        fn.EmitLoad(half, Value::From(0.5));
+        fn.EmitLoad(one, Value::From(1.0));
+        fn.EmitLoad(i, Value::From<std::int64_t>(0));
+        fn.Bind(head);
+        fn.EmitBranch(Opcode::BrGe_I64, i, fn.Param(0), done);
+        fn.Emit(Opcode::Mul_F64, x, x, half);
+        fn.Emit(Opcode::Add_F64, x, x, one);
+        fn.Emit(Opcode::AddImm_I64, i, i, 1);
+        fn.EmitJump(head);
+        fn.Bind(done);
+        fn.Emit(Opcode::FToI_F64, x, x);
+        fn.Emit(Opcode::Ret, x);
+    }
+
+    // Recursive fib, dominated by calls and returns
+    void Fib(FunctionBuilder &fn)
+    {
+        auto n = fn.Param(0);
+        auto two = fn.NewRegister();
+        auto lhs = fn.NewRegister();
+        auto rhs = fn.NewRegister();
+        auto recurse = fn.NewLabel();
+        fn.EmitLoad(two, Value::From<std::int64_t>(2));
+        fn.EmitBranch(Opcode::BrGe_I64, n, two, recurse);
+        fn.Emit(Opcode::Ret, n);
+        fn.Bind(recurse);
+        fn.Emit(Opcode::AddImm_I64, lhs, n, static_cast<std::uint16_t>(-1));
+        fn.Emit(Opcode::Call, lhs, 0, 1);
+        fn.Emit(Opcode::AddImm_I64, rhs, n, static_cast<std::uint16_t>(-2));
+        fn.Emit(Opcode::Call, rhs, 0, 1);
+        fn.Emit(Opcode::Add_I64, lhs, lhs, rhs);
+        fn.Emit(Opcode::Ret, lhs);
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    double const scale = argc > 1 ? std::atof(argv[1]) : 1.0;
+    std::vector<Program> programs{
+            {"sum-loop", SumLoop, static_cast<std::int64_t>(50'000'000 * scale)},
+            {"nested-loops", NestedLoops, static_cast<std::int64_t>(4'000 * std::sqrt(scale))},
+            {"float-loop", FloatLoop, static_cast<std::int64_t>(50'000'000 * scale)},
+            {"fib", Fib, 30},
+    };
+
+    std::cout << std::left << std::setw(14) << "program" << std::right << std::setw(14) << "instructions"
+              << std::setw(12) << "ms" << std::setw(12) << "Minstr/s" << "\n";
+    for (auto const &program: programs) {
+        Bytecode::Module module;
+        FunctionBuilder fn(module, program.name, 1, Type::I64);
+        program.build(fn);
+        std::string error;
+        if (!fn.Finish(error)) {
+            std::cerr << "error: " << error << "\n";
+            return 1;
+        }
+        auto interp = Bytecode::Interpreter::Create(std::move(module), error);
+        if (!interp) {
+            std::cerr << "error: " << error << "\n";
+            return 1;
+        }
+
+        // One counted run for the instruction count, then an uncounted one for the time
+        std::array args{Value::From(program.argument)};
+        interp->SetCountInstructions(true);
+        interp->Call(0, args, error);
+        auto const instructions = interp->InstructionsExecuted();
+        interp->SetCountInstructions(false);
+
+        auto const start = std::chrono::steady_clock::now();
+        auto result = interp->Call(0, args, error);
+        auto const elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (!result) {
+            std::cerr << "error: " << error << "\n";
+            return 1;
+        }
+
+        std::cout << std::left << std::setw(14) << program.name << std::right << std::setw(14) << instructions
+                  << std::setw(12) << std::fixed << std::setprecision(1) << elapsed * 1e3 << std::setw(12)
+                  << instructions / elapsed / 1e6 << "\n";
+    }
+    return 0;
+}
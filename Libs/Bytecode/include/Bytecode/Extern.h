@@ -0,0 +1,29 @@
+#pragma once
+#include <Bytecode/Module.h>
+
+#include <string>
+
+namespace Bytecode
+{
+
+    // The bridge calls foreign functions through one fixed shape: six integer and eight floating point arguments,
+    // declared variadic so that the callee sees how many vector registers are used. This matches any C signature
+    // within those limits on ABIs that assign integer and floating point argument registers independently and pass
+    // variadic arguments like fixed ones (System V x86-64, AAPCS64 outside Apple platforms).
+#if (defined(__x86_64__) && !defined(_WIN32)) || (defined(__aarch64__) && !defined(__APPLE__))
+#define WAFFLE_EXTERN_BRIDGE_SUPPORTED 1
+#else
+#define WAFFLE_EXTERN_BRIDGE_SUPPORTED 0
+#endif
+
+    constexpr std::size_t kMaxExternIntArgs = 6;
+    constexpr std::size_t kMaxExternFloatArgs = 8;
+
+    // Checks that the bridge can call `function` and looks up its address by name if it has none. Returns false
+    // with `error` set otherwise.
+    bool ResolveExtern(ExternFunction &function, std::string &error);
+
+    // Calls a resolved extern with `function.params.size()` arguments starting at `args`.
+    Value CallExtern(ExternFunction const &function, Value const *args);
+
+} // namespace Bytecode
@@ -0,0 +1,58 @@
+#pragma once
+#include <Bytecode/Module.h>
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace Bytecode
+{
+
+    // Checks every operand of every instruction against the module, so the interpreter loop can run unchecked.
+    bool Verify(Module const &module, std::string &error);
+
+    class Interpreter
+    {
+    public:
+        // Verifies the module and resolves its externs; returns std::nullopt with `error` set on failure.
+        static std::optional<Interpreter> Create(Module module, std::string &error);
+
+        // Runs a function to completion. Returns its result (zero for void functions), or std::nullopt with
+        // `error` set when the program traps.
+        std::optional<Value> Call(std::uint32_t function, std::span<Value const> args, std::string &error);
+
+        // Counting costs an increment per instruction and is off by default.
+        void SetCountInstructions(bool count) { count_instructions_ = count; }
+        [[nodiscard]] std::uint64_t InstructionsExecuted() const { return instructions_executed_; }
+
+        [[nodiscard]] Module const &GetModule() const { return module_; }
+
+    private:
+        struct Frame
+        {
+            Instr const *return_ip;
+            std::size_t base;
+            std::size_t size;     // the caller's num_registers
+            std::uint16_t result; // caller register that receives the return value
+        };
+
+        static constexpr std::size_t kInitialStackSlots = 1 << 12;
+        static constexpr std::size_t kMaxStackSlots = 1 << 22;
+        static constexpr std::size_t kMaxCallDepth = 1 << 16;
+
+        Module module_;
+        std::vector<Value> registers_;
+        std::vector<Frame> frames_;
+        bool count_instructions_ = false;
+        std::uint64_t instructions_executed_ = 0;
+
+        explicit Interpreter(Module module);
+
+        template<bool kCount>
+        std::optional<Value> Execute_(Function const &entry, std::string &error);
+        bool EnsureStack_(std::size_t slots);
+    };
+
+} // namespace Bytecode
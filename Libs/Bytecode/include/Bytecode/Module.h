@@ -0,0 +1,149 @@
+#pragma once
+#include <Bytecode/Opcode.h>
+#include <Lexer/Types.h>
+
+#include <bit>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace Bytecode
+{
+
+    // A register slot. Integers are stored sign- or zero-extended to 64 bits, fp32 in the low 32 bits.
+    struct Value
+    {
+        std::uint64_t bits = 0;
+
+        template<typename T>
+        [[nodiscard]] static constexpr Value From(T value)
+        {
+            if constexpr (std::is_same_v<T, float>) {
+                return {std::bit_cast<std::uint32_t>(value)};
+            }
+            else if constexpr (std::is_same_v<T, double>) {
+                return {std::bit_cast<std::uint64_t>(value)};
+            }
+            else if constexpr (std::is_pointer_v<T>) {
+                return {reinterpret_cast<std::uintptr_t>(value)};
+            }
+            else {
+                // Converting through int64 sign-extends signed types and zero-extends unsigned ones
+                return {static_cast<std::uint64_t>(static_cast<std::conditional_t<std::is_signed_v<T>, std::int64_t,
+                                                                                   std::uint64_t>>(value))};
+            }
+        }
+
+        template<typename T>
+        [[nodiscard]] constexpr T As() const
+        {
+            if constexpr (std::is_same_v<T, float>) {
+                return std::bit_cast<float>(static_cast<std::uint32_t>(bits));
+            }
+            else if constexpr (std::is_same_v<T, double>) {
+                return std::bit_cast<double>(bits);
+            }
+            else if constexpr (std::is_pointer_v<T>) {
+                return reinterpret_cast<T>(static_cast<std::uintptr_t>(bits));
+            }
+            else {
+                return static_cast<T>(bits);
+            }
+        }
+    };
+
+    struct Function
+    {
+        std::string name;
+        std::uint16_t num_params = 0;
+        std::uint16_t num_registers = 0;
+        Type ret = Type::Void;
+        std::vector<Instr> code;
+    };
+
+    // A foreign function called through the extern "C" bridge. Each distinct call shape of a variadic function such
+    // as printf gets its own entry, with `params` listing the fixed and the variadic arguments of that shape.
+    struct ExternFunction
+    {
+        std::string name;
+        std::vector<Type> params;
+        std::size_t fixed_params = 0; // number of non-variadic leading params, equal to params.size() if !variadic
+        bool variadic = false;
+        Type ret = Type::Void;
+        void *address = nullptr; // resolved by symbol name when null
+    };
+
+    struct Module
+    {
+        std::vector<Function> functions;
+        std::vector<ExternFunction> externs;
+        std::vector<std::uint64_t> constants;
+        std::vector<std::string> strings;
+
+        std::uint32_t AddConstant(Value value);
+        std::uint32_t AddString(std::string_view text);
+        std::uint32_t AddExtern(ExternFunction function);
+        [[nodiscard]] std::optional<std::uint32_t> FindFunction(std::string_view name) const;
+    };
+
+    using Reg = std::uint16_t;
+
+    struct Label
+    {
+        std::uint32_t id;
+    };
+
+    // Appends one function to a module. Registers 0..num_params-1 hold the arguments on entry.
+    class FunctionBuilder
+    {
+    public:
+        FunctionBuilder(Module &module, std::string name, std::uint16_t num_params, Type ret);
+
+        [[nodiscard]] Reg Param(std::uint16_t index) const { return index; }
+        Reg NewRegister();
+        // Consecutive registers, as needed for call arguments
+        Reg NewRegisters(std::uint16_t count);
+
+        Label NewLabel();
+        void Bind(Label label);
+
+        void Emit(Opcode op, Reg a = 0, std::uint16_t b = 0, std::uint16_t c = 0);
+        void EmitImm(Opcode op, Reg a, std::int32_t imm);
+        void EmitLoad(Reg a, Value value);
+        void EmitJump(Label target);
+        void EmitJumpIf(bool condition, Reg a, Label target);
+        void EmitBranch(Opcode op, Reg a, Reg b, Label target);
+
+        // Resolves labels and adds the function to the module. Returns its index, or std::nullopt with `error` set
+        // if a jump does not fit its offset field or a label was never bound.
+        std::optional<std::uint32_t> Finish(std::string &error);
+
+    private:
+        struct Fixup
+        {
+            std::size_t instr;
+            std::uint32_t label;
+            bool wide; // 32-bit immediate instead of the 16-bit c field
+        };
+
+        Module &module_;
+        Function function_;
+        std::vector<std::optional<std::size_t>> labels_;
+        std::vector<Fixup> fixups_;
+    };
+
+    // Maps Waffle types and operators onto typed opcodes. Compound assignments select the opcode of their
+    // operator, ++/-- select AddImm (with an immediate of +1/-1), && and || on bools select And/Or for operands
+    // without side effects. Returns std::nullopt when the operator is not defined for the type.
+    [[nodiscard]] std::optional<Type> TypeFromToken(Lexer::TokenKind kind);
+    [[nodiscard]] std::optional<Opcode> SelectBinary(Lexer::TokenKind op, Type type);
+    [[nodiscard]] std::optional<Opcode> SelectUnary(Lexer::TokenKind op, Type type);
+    [[nodiscard]] std::optional<Opcode> SelectBranch(Lexer::TokenKind op, Type type);
+    // Opcodes that convert a value of type `from` into `to`, applied in order; empty if the representation is
+    // already correct, std::nullopt if there is no such conversion.
+    [[nodiscard]] std::optional<std::vector<Opcode>> SelectConversion(Type from, Type to);
+
+} // namespace Bytecode
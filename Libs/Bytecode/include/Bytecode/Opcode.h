@@ -0,0 +1,159 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+
+namespace Bytecode
+{
+
+    enum class Type : std::uint8_t
+    {
+        Void,
+        Bool,
+        I8,
+        I16,
+        I32,
+        I64,
+        U8,
+        U16,
+        U32,
+        U64,
+        F32,
+        F64,
+        Ptr // only produced by LoadString and host arguments, for extern calls
+    };
+
+    std::ostream &operator<<(std::ostream &os, Type type);
+
+    [[nodiscard]] constexpr bool IsInteger(Type type) { return type >= Type::I8 && type <= Type::U64; }
+    [[nodiscard]] constexpr bool IsSigned(Type type) { return type >= Type::I8 && type <= Type::I64; }
+    [[nodiscard]] constexpr bool IsFloat(Type type) { return type == Type::F32 || type == Type::F64; }
+
+    // Typed opcodes are generated from the operation lists below, one opcode per operation and type, e.g. Add_I32
+    // or BrLt_U64. Integer registers always hold the value sign- or zero-extended to 64 bits, so every integer
+    // opcode re-canonicalizes its result for its width.
+    //
+    // Arithmetic wraps around; shift counts are taken modulo the bit width; division or remainder by zero traps.
+    // Float to integer conversions saturate and map NaN to zero.
+
+#define WAFFLE_INT_TYPES(M, OP)                                                                                        \
+    M(OP, I8, std::int8_t)                                                                                             \
+    M(OP, I16, std::int16_t)                                                                                           \
+    M(OP, I32, std::int32_t)                                                                                           \
+    M(OP, I64, std::int64_t)                                                                                           \
+    M(OP, U8, std::uint8_t)                                                                                            \
+    M(OP, U16, std::uint16_t)                                                                                          \
+    M(OP, U32, std::uint32_t)                                                                                          \
+    M(OP, U64, std::uint64_t)
+
+#define WAFFLE_FLOAT_TYPES(M, OP)                                                                                      \
+    M(OP, F32, float)                                                                                                  \
+    M(OP, F64, double)
+
+    // a = b op c
+#define WAFFLE_INT_BINARY_OPS(M) M(Add) M(Sub) M(Mul) M(Div) M(Rem) M(And) M(Or) M(Xor) M(Shl) M(Shr)
+#define WAFFLE_FLOAT_BINARY_OPS(M) M(Add) M(Sub) M(Mul) M(Div)
+    // a = b cmp c, result is a bool
+#define WAFFLE_COMPARE_OPS(M) M(Eq) M(Ne) M(Lt) M(Le) M(Gt) M(Ge)
+    // if (a cmp b) jump by the signed offset c
+#define WAFFLE_BRANCH_OPS(M) M(BrEq) M(BrNe) M(BrLt) M(BrLe) M(BrGt) M(BrGe)
+    // a = op b; Cast converts any canonical integer to the opcode's type, Sat clamps a 64-bit integer of the same
+    // signedness to the opcode's range
+#define WAFFLE_INT_UNARY_OPS(M) M(Neg) M(BitNot) M(Cast) M(Sat)
+#define WAFFLE_FLOAT_UNARY_OPS(M) M(Neg)
+
+    // Untyped opcodes and their operand format
+#define WAFFLE_BASIC_OPS(M)                                                                                            \
+    M(Nop, None)                                                                                                       \
+    M(Move, AB)           /* a = b */                                                                                  \
+    M(LoadImm, AImm)      /* a = sign-extended imm */                                                                  \
+    M(LoadConst, AConst)  /* a = constants[imm] */                                                                     \
+    M(LoadString, AStr)   /* a = pointer to strings[imm] */                                                            \
+    M(Not, AB)            /* a = !b for bools */                                                                       \
+    M(Jump, Jump)         /* ip += imm */                                                                              \
+    M(JumpIfTrue, AJump)  /* if (a) ip += imm */                                                                       \
+    M(JumpIfFalse, AJump) /* if (!a) ip += imm */                                                                      \
+    M(Call, Call)         /* a = functions[b](a, ..., a + c - 1), callee runs in a fresh frame above the caller's */   \
+    M(CallExtern, Extern) /* a = externs[b](a, ..., a + c - 1) */                                                      \
+    M(Ret, A)             /* return a */                                                                               \
+    M(RetVoid, None)                                                                                                   \
+    M(IToF_F32, AB)       /* signed int64 to float */                                                                  \
+    M(IToF_F64, AB)                                                                                                    \
+    M(UToF_F32, AB)       /* unsigned int64 to float */                                                                \
+    M(UToF_F64, AB)                                                                                                    \
+    M(FToI_F32, AB)       /* float to int64 */                                                                         \
+    M(FToI_F64, AB)                                                                                                    \
+    M(FToU_F32, AB)       /* float to uint64 */                                                                        \
+    M(FToU_F64, AB)                                                                                                    \
+    M(F32ToF64, AB)                                                                                                    \
+    M(F64ToF32, AB)
+
+    enum class Format : std::uint8_t
+    {
+        None,
+        A,
+        AB,
+        ABC,
+        ABImm,
+        AImm,
+        AConst,
+        AStr,
+        Jump,
+        AJump,
+        Branch,
+        Call,
+        Extern
+    };
+
+#define WAFFLE_BASIC_ENUMERATOR(NAME, FORMAT) NAME,
+#define WAFFLE_TYPED_ENUMERATOR(OP, T, C) OP##_##T,
+#define WAFFLE_INT_ENUMERATORS(OP) WAFFLE_INT_TYPES(WAFFLE_TYPED_ENUMERATOR, OP)
+#define WAFFLE_FLOAT_ENUMERATORS(OP) WAFFLE_FLOAT_TYPES(WAFFLE_TYPED_ENUMERATOR, OP)
+
+    enum class Opcode : std::uint16_t
+    {
+        WAFFLE_BASIC_OPS(WAFFLE_BASIC_ENUMERATOR)
+        WAFFLE_INT_BINARY_OPS(WAFFLE_INT_ENUMERATORS)
+        WAFFLE_COMPARE_OPS(WAFFLE_INT_ENUMERATORS)
+        WAFFLE_BRANCH_OPS(WAFFLE_INT_ENUMERATORS)
+        WAFFLE_INT_UNARY_OPS(WAFFLE_INT_ENUMERATORS)
+        WAFFLE_INT_ENUMERATORS(AddImm) // a = b + sign-extended c
+        WAFFLE_FLOAT_BINARY_OPS(WAFFLE_FLOAT_ENUMERATORS)
+        WAFFLE_COMPARE_OPS(WAFFLE_FLOAT_ENUMERATORS)
+        WAFFLE_BRANCH_OPS(WAFFLE_FLOAT_ENUMERATORS)
+        WAFFLE_FLOAT_UNARY_OPS(WAFFLE_FLOAT_ENUMERATORS)
+        Count
+    };
+
+    std::ostream &operator<<(std::ostream &os, Opcode op);
+
+    [[nodiscard]] std::string_view OpcodeName(Opcode op);
+    [[nodiscard]] Format OpcodeFormat(Opcode op);
+
+    // Fixed 64-bit instruction. Formats with a 32-bit immediate store it in b and c, low half first. Jump offsets are
+    // relative to the instruction following the jump.
+    struct Instr
+    {
+        Opcode op;
+        std::uint16_t a;
+        std::uint16_t b;
+        std::uint16_t c;
+
+        [[nodiscard]] constexpr std::int32_t Imm() const
+        {
+            return static_cast<std::int32_t>(static_cast<std::uint32_t>(b) | static_cast<std::uint32_t>(c) << 16);
+        }
+
+        [[nodiscard]] constexpr std::int16_t Offset() const { return static_cast<std::int16_t>(c); }
+
+        static constexpr Instr WithImm(Opcode op, std::uint16_t a, std::int32_t imm)
+        {
+            auto bits = static_cast<std::uint32_t>(imm);
+            return {op, a, static_cast<std::uint16_t>(bits), static_cast<std::uint16_t>(bits >> 16)};
+        }
+    };
+
+    static_assert(sizeof(Instr) == 8);
+
+} // namespace Bytecode
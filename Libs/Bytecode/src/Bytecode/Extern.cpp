@@ -0,0 +1,108 @@
+#include <Bytecode/Extern.h>
+
+#include <array>
+
+#include <dlfcn.h>
+
+namespace Bytecode
+{
+
+    namespace Detail
+    {
+        using IntShape = std::int64_t (*)(std::int64_t, ...);
+        using DoubleShape = double (*)(std::int64_t, ...);
+        using FloatShape = float (*)(std::int64_t, ...);
+
+        bool IsIntClass(Type type) { return IsInteger(type) || type == Type::Bool || type == Type::Ptr; }
+    } // namespace Detail
+
+    bool ResolveExtern(ExternFunction &function, std::string &error)
+    {
+        if (!WAFFLE_EXTERN_BRIDGE_SUPPORTED) {
+            error = function.name + ": extern calls are not supported on this platform";
+            return false;
+        }
+        if (!function.variadic) {
+            function.fixed_params = function.params.size();
+        }
+
+        std::size_t ints = 0;
+        std::size_t floats = 0;
+        for (std::size_t i = 0; i < function.params.size(); ++i) {
+            auto const type = function.params[i];
+            if (Detail::IsIntClass(type)) {
+                ints++;
+            }
+            else if (type == Type::F64 || (type == Type::F32 && i >= function.fixed_params)) {
+                // Variadic fp32 arguments are promoted to double like in C
+                floats++;
+            }
+            else {
+                error = function.name + ": unsupported parameter type for extern calls";
+                return false;
+            }
+        }
+        if (ints > kMaxExternIntArgs || floats > kMaxExternFloatArgs) {
+            error = function.name + ": too many arguments for extern calls";
+            return false;
+        }
+        if (function.ret == Type::Ptr) {
+            error = function.name + ": unsupported return type for extern calls";
+            return false;
+        }
+
+        if (!function.address) {
+            function.address = ::dlsym(RTLD_DEFAULT, function.name.c_str());
+            if (!function.address) {
+                error = function.name + ": symbol not found";
+                return false;
+            }
+        }
+        return true;
+    }
+
+    Value CallExtern(ExternFunction const &function, Value const *args)
+    {
+        std::array<std::int64_t, kMaxExternIntArgs> ints{};
+        std::array<double, kMaxExternFloatArgs> floats{};
+        std::size_t next_int = 0;
+        std::size_t next_float = 0;
+
+        for (std::size_t i = 0; i < function.params.size(); ++i) {
+            switch (function.params[i]) {
+                case Type::F64: floats[next_float++] = args[i].As<double>(); break;
+                case Type::F32: floats[next_float++] = args[i].As<float>(); break;
+                default: ints[next_int++] = static_cast<std::int64_t>(args[i].bits); break;
+            }
+        }
+
+#define WAFFLE_EXTERN_ARGS                                                                                             \
+    ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], floats[0], floats[1], floats[2], floats[3], floats[4],       \
+            floats[5], floats[6], floats[7]
+
+        switch (function.ret) {
+            case Type::F64:
+                return Value::From(reinterpret_cast<Detail::DoubleShape>(function.address)(WAFFLE_EXTERN_ARGS));
+            case Type::F32:
+                return Value::From(reinterpret_cast<Detail::FloatShape>(function.address)(WAFFLE_EXTERN_ARGS));
+            default: break;
+        }
+        auto result = reinterpret_cast<Detail::IntShape>(function.address)(WAFFLE_EXTERN_ARGS);
+
+#undef WAFFLE_EXTERN_ARGS
+
+        // Only the low bits of narrower return values are defined
+        switch (function.ret) {
+            case Type::Void: return {};
+            case Type::Bool: return Value::From(static_cast<bool>(static_cast<std::uint8_t>(result)));
+            case Type::I8: return Value::From(static_cast<std::int8_t>(result));
+            case Type::I16: return Value::From(static_cast<std::int16_t>(result));
+            case Type::I32: return Value::From(static_cast<std::int32_t>(result));
+            case Type::U8: return Value::From(static_cast<std::uint8_t>(result));
+            case Type::U16: return Value::From(static_cast<std::uint16_t>(result));
+            case Type::U32: return Value::From(static_cast<std::uint32_t>(result));
+            default: return Value::From(result);
+        }
+    }
+
+} // namespace Bytecode
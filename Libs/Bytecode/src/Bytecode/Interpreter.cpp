@@ -0,0 +1,478 @@
+#include <Bytecode/Extern.h>
+#include <Bytecode/Interpreter.h>
+
+#include <algorithm>
+#include <limits>
+#include <type_traits>
+
+// Labels as values give every handler its own indirect jump, which predicts much better than a shared switch
+#if defined(__GNUC__)
+#define WAFFLE_COMPUTED_GOTO 1
+#else
+#define WAFFLE_COMPUTED_GOTO 0
+#endif
+
+namespace Bytecode
+{
+
+    namespace Detail
+    {
+        // Integer arithmetic goes through uint64 so it wraps instead of overflowing (also after integer promotion)
+        template<typename T>
+        constexpr T Wrap(std::uint64_t value)
+        {
+            return static_cast<T>(value);
+        }
+
+        template<typename T>
+        constexpr std::uint64_t Widen(T value)
+        {
+            return static_cast<std::uint64_t>(value);
+        }
+
+        template<typename T>
+        constexpr unsigned ShiftCount(T count)
+        {
+            return static_cast<unsigned>(Widen(count) & (sizeof(T) * 8 - 1));
+        }
+
+        template<typename T>
+        constexpr T Div(T x, T y)
+        {
+            if constexpr (std::is_signed_v<T>) {
+                if (y == -1) {
+                    return Wrap<T>(0 - Widen(x));
+                }
+            }
+            return static_cast<T>(x / y);
+        }
+
+        template<typename T>
+        constexpr T Rem(T x, T y)
+        {
+            if constexpr (std::is_signed_v<T>) {
+                if (y == -1) {
+                    return 0;
+                }
+            }
+            return static_cast<T>(x % y);
+        }
+
+        template<typename F>
+        constexpr std::int64_t SaturateToI64(F value)
+        {
+            if (value != value) {
+                return 0;
+            }
+            if (value <= static_cast<F>(std::numeric_limits<std::int64_t>::min())) {
+                return std::numeric_limits<std::int64_t>::min();
+            }
+            if (value >= static_cast<F>(9223372036854775808.0)) {
+                return std::numeric_limits<std::int64_t>::max();
+            }
+            return static_cast<std::int64_t>(value);
+        }
+
+        template<typename F>
+        constexpr std::uint64_t SaturateToU64(F value)
+        {
+            if (value != value || value <= static_cast<F>(0)) {
+                return 0;
+            }
+            if (value >= static_cast<F>(18446744073709551616.0)) {
+                return std::numeric_limits<std::uint64_t>::max();
+            }
+            return static_cast<std::uint64_t>(value);
+        }
+
+        // Clamps a register holding a 64-bit integer (signed if T is) to the range of T
+        template<typename T>
+        constexpr T Saturate(Value value)
+        {
+            if constexpr (std::is_signed_v<T>) {
+                auto const x = value.As<std::int64_t>();
+                return static_cast<T>(std::clamp<std::int64_t>(x, std::numeric_limits<T>::min(),
+                                                               std::numeric_limits<T>::max()));
+            }
+            else {
+                auto const x = value.As<std::uint64_t>();
+                return static_cast<T>(std::min<std::uint64_t>(x, std::numeric_limits<T>::max()));
+            }
+        }
+
+        bool Fail(std::string &error, std::string message)
+        {
+            error = std::move(message);
+            return false;
+        }
+
+        bool VerifyFunction(Module const &module, Function const &function, std::string &error)
+        {
+            auto const &code = function.code;
+            auto reg = [&](std::uint32_t index) { return index < function.num_registers; };
+            auto target = [&](std::size_t at, std::int64_t offset) {
+                auto const destination = static_cast<std::int64_t>(at) + 1 + offset;
+                return destination >= 0 && destination < static_cast<std::int64_t>(code.size());
+            };
+
+            if (function.num_registers < function.num_params) {
+                return Fail(error, function.name + ": fewer registers than parameters");
+            }
+            if (code.empty() || (code.back().op != Opcode::Ret && code.back().op != Opcode::RetVoid &&
+                                 code.back().op != Opcode::Jump)) {
+                return Fail(error, function.name + ": code does not end in a return or jump");
+            }
+
+            for (std::size_t at = 0; at < code.size(); ++at) {
+                auto const &in = code[at];
+                if (in.op >= Opcode::Count) {
+                    return Fail(error, function.name + ": invalid opcode at " + std::to_string(at));
+                }
+
+                bool ok = true;
+                switch (OpcodeFormat(in.op)) {
+                    case Format::None: break;
+                    case Format::A: ok = reg(in.a); break;
+                    case Format::AB:
+                    case Format::ABImm: ok = reg(in.a) && reg(in.b); break;
+                    case Format::ABC: ok = reg(in.a) && reg(in.b) && reg(in.c); break;
+                    case Format::AImm: ok = reg(in.a); break;
+                    case Format::AConst:
+                        ok = reg(in.a) && static_cast<std::uint32_t>(in.Imm()) < module.constants.size();
+                        break;
+                    case Format::AStr:
+                        ok = reg(in.a) && static_cast<std::uint32_t>(in.Imm()) < module.strings.size();
+                        break;
+                    case Format::Jump: ok = target(at, in.Imm()); break;
+                    case Format::AJump: ok = reg(in.a) && target(at, in.Imm()); break;
+                    case Format::Branch: ok = reg(in.a) && reg(in.b) && target(at, in.Offset()); break;
+                    case Format::Call:
+                        ok = in.b < module.functions.size() && reg(in.a) && in.a + in.c <= function.num_registers &&
+                             in.c == module.functions[in.b].num_params;
+                        break;
+                    case Format::Extern:
+                        ok = in.b < module.externs.size() && reg(in.a) && in.a + in.c <= function.num_registers &&
+                             in.c == module.externs[in.b].params.size();
+                        break;
+                }
+                if (!ok) {
+                    return Fail(error, function.name + ": invalid operands for " + std::string(OpcodeName(in.op)) +
+                                               " at " + std::to_string(at));
+                }
+            }
+            return true;
+        }
+    } // namespace Detail
+
+    bool Verify(Module const &module, std::string &error)
+    {
+        for (auto const &function: module.functions) {
+            if (!Detail::VerifyFunction(module, function, error)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::optional<Interpreter> Interpreter::Create(Module module, std::string &error)
+    {
+        if (!Verify(module, error)) {
+            return std::nullopt;
+        }
+        for (auto &function: module.externs) {
+            if (!ResolveExtern(function, error)) {
+                return std::nullopt;
+            }
+        }
+        return Interpreter(std::move(module));
+    }
+
+    Interpreter::Interpreter(Module module) : module_(std::move(module)), registers_(kInitialStackSlots) {}
+
+    std::optional<Value> Interpreter::Call(std::uint32_t function, std::span<Value const> args, std::string &error)
+    {
+        if (function >= module_.functions.size()) {
+            error = "no function with index " + std::to_string(function);
+            return std::nullopt;
+        }
+        auto const &entry = module_.functions[function];
+        if (args.size() != entry.num_params) {
+            error = entry.name + ": expected " + std::to_string(entry.num_params) + " arguments";
+            return std::nullopt;
+        }
+        if (!EnsureStack_(entry.num_registers)) {
+            error = "stack overflow";
+            return std::nullopt;
+        }
+
+        std::ranges::copy(args, registers_.begin());
+        frames_.clear();
+        return count_instructions_ ? Execute_<true>(entry, error) : Execute_<false>(entry, error);
+    }
+
+    bool Interpreter::EnsureStack_(std::size_t slots)
+    {
+        if (slots <= registers_.size()) {
+            return true;
+        }
+        if (slots > kMaxStackSlots) {
+            return false;
+        }
+        registers_.resize(std::max(slots, std::min(registers_.size() * 2, kMaxStackSlots)));
+        return true;
+    }
+
+    template<bool kCount>
+    std::optional<Value> Interpreter::Execute_(Function const &entry, std::string &error)
+    {
+        Instr const *ip = entry.code.data();
+        std::size_t base = 0;
+        std::size_t frame_size = entry.num_registers;
+        Value *r = registers_.data();
+        Value result;
+        std::uint64_t executed = 0;
+
+        auto trap = [&](std::string message) -> std::optional<Value> {
+            error = std::move(message);
+            instructions_executed_ += executed;
+            return std::nullopt;
+        };
+
+        // Every handler starts at a label named after its opcode
+#if WAFFLE_COMPUTED_GOTO
+#define WAFFLE_LABEL_ADDRESS(NAME, FORMAT) &&Op_##NAME,
+#define WAFFLE_TYPED_LABEL_ADDRESS(OP, T, C) &&Op_##OP##_##T,
+#define WAFFLE_INT_LABEL_ADDRESSES(OP) WAFFLE_INT_TYPES(WAFFLE_TYPED_LABEL_ADDRESS, OP)
+#define WAFFLE_FLOAT_LABEL_ADDRESSES(OP) WAFFLE_FLOAT_TYPES(WAFFLE_TYPED_LABEL_ADDRESS, OP)
+        static void *const kDispatch[] = {
+                WAFFLE_BASIC_OPS(WAFFLE_LABEL_ADDRESS)
+                WAFFLE_INT_BINARY_OPS(WAFFLE_INT_LABEL_ADDRESSES)
+                WAFFLE_COMPARE_OPS(WAFFLE_INT_LABEL_ADDRESSES)
+                WAFFLE_BRANCH_OPS(WAFFLE_INT_LABEL_ADDRESSES)
+                WAFFLE_INT_UNARY_OPS(WAFFLE_INT_LABEL_ADDRESSES)
+                WAFFLE_INT_LABEL_ADDRESSES(AddImm)
+                WAFFLE_FLOAT_BINARY_OPS(WAFFLE_FLOAT_LABEL_ADDRESSES)
+                WAFFLE_COMPARE_OPS(WAFFLE_FLOAT_LABEL_ADDRESSES)
+                WAFFLE_BRANCH_OPS(WAFFLE_FLOAT_LABEL_ADDRESSES)
+                WAFFLE_FLOAT_UNARY_OPS(WAFFLE_FLOAT_LABEL_ADDRESSES)
+        };
+        static_assert(std::size(kDispatch) == static_cast<std::size_t>(Opcode::Count));
+#define WAFFLE_HANDLER(NAME) Op_##NAME:
+#define WAFFLE_DISPATCH()                                                                                              \
+    do {                                                                                                               \
+        if constexpr (kCount) {                                                                                        \
+            executed++;                                                                                                \
+        }                                                                                                              \
+        goto *kDispatch[static_cast<std::size_t>(ip->op)];                                                             \
+    }                                                                                                                  \
+    while (false)
+#else
+#define WAFFLE_HANDLER(NAME) case Opcode::NAME:
+#define WAFFLE_DISPATCH() goto dispatch
+#endif
+#define WAFFLE_NEXT()                                                                                                  \
+    do {                                                                                                               \
+        ++ip;                                                                                                          \
+        WAFFLE_DISPATCH();                                                                                             \
+    }                                                                                                                  \
+    while (false)
+#define WAFFLE_JUMP(OFFSET)                                                                                            \
+    do {                                                                                                               \
+        ip += 1 + (OFFSET);                                                                                            \
+        WAFFLE_DISPATCH();                                                                                             \
+    }                                                                                                                  \
+    while (false)
+
+        // Typed handlers, instantiated once per opcode type
+#define WAFFLE_BINARY_HANDLER(OP, T, C, EXPR)                                                                          \
+    WAFFLE_HANDLER(OP##_##T)                                                                                           \
+    {                                                                                                                  \
+        C const x = r[ip->b].As<C>();                                                                                  \
+        C const y = r[ip->c].As<C>();                                                                                  \
+        r[ip->a] = Value::From(EXPR);                                                                                  \
+        WAFFLE_NEXT();                                                                                                 \
+    }
+#define WAFFLE_CHECKED_BINARY_HANDLER(OP, T, C, EXPR)                                                                  \
+    WAFFLE_HANDLER(OP##_##T)                                                                                           \
+    {                                                                                                                  \
+        C const x = r[ip->b].As<C>();                                                                                  \
+        C const y = r[ip->c].As<C>();                                                                                  \
+        if (y == 0) {                                                                                                  \
+            return trap("division by zero");                                                                          \
+        }                                                                                                              \
+        r[ip->a] = Value::From(EXPR);                                                                                  \
+        WAFFLE_NEXT();                                                                                                 \
+    }
+#define WAFFLE_CONVERSION_HANDLER(OP, C, EXPR)                                                                         \
+    WAFFLE_HANDLER(OP)                                                                                                 \
+    {                                                                                                                  \
+        C const x = r[ip->b].As<C>();                                                                                  \
+        r[ip->a] = Value::From(EXPR);                                                                                  \
+        WAFFLE_NEXT();                                                                                                 \
+    }
+#define WAFFLE_UNARY_HANDLER(OP, T, C, EXPR)                                                                           \
+    WAFFLE_HANDLER(OP##_##T)                                                                                           \
+    {                                                                                                                  \
+        C const x = r[ip->b].As<C>();                                                                                  \
+        r[ip->a] = Value::From(EXPR);                                                                                  \
+        WAFFLE_NEXT();                                                                                                 \
+    }
+#define WAFFLE_SATURATE_HANDLER(T, C)                                                                                  \
+    WAFFLE_HANDLER(Sat_##T)                                                                                            \
+    {                                                                                                                  \
+        r[ip->a] = Value::From(Detail::Saturate<C>(r[ip->b]));                                                         \
+        WAFFLE_NEXT();                                                                                                 \
+    }
+#define WAFFLE_BRANCH_HANDLER(OP, T, C, CMP)                                                                           \
+    WAFFLE_HANDLER(OP##_##T)                                                                                           \
+    {                                                                                                                  \
+        C const x = r[ip->a].As<C>();                                                                                  \
+        C const y = r[ip->b].As<C>();                                                                                  \
+        WAFFLE_JUMP((x CMP y) ? ip->Offset() : 0);                                                                     \
+    }
+#define WAFFLE_COMPARE_HANDLERS(T, C)                                                                                  \
+    WAFFLE_BINARY_HANDLER(Eq, T, C, x == y)                                                                            \
+    WAFFLE_BINARY_HANDLER(Ne, T, C, x != y)                                                                            \
+    WAFFLE_BINARY_HANDLER(Lt, T, C, x < y)                                                                             \
+    WAFFLE_BINARY_HANDLER(Le, T, C, x <= y)                                                                            \
+    WAFFLE_BINARY_HANDLER(Gt, T, C, x > y)                                                                             \
+    WAFFLE_BINARY_HANDLER(Ge, T, C, x >= y)                                                                            \
+    WAFFLE_BRANCH_HANDLER(BrEq, T, C, ==)                                                                              \
+    WAFFLE_BRANCH_HANDLER(BrNe, T, C, !=)                                                                              \
+    WAFFLE_BRANCH_HANDLER(BrLt, T, C, <)                                                                               \
+    WAFFLE_BRANCH_HANDLER(BrLe, T, C, <=)                                                                              \
+    WAFFLE_BRANCH_HANDLER(BrGt, T, C, >)                                                                               \
+    WAFFLE_BRANCH_HANDLER(BrGe, T, C, >=)
+#define WAFFLE_INT_HANDLERS(UNUSED, T, C)                                                                              \
+    WAFFLE_BINARY_HANDLER(Add, T, C, Detail::Wrap<C>(Detail::Widen(x) + Detail::Widen(y)))                             \
+    WAFFLE_BINARY_HANDLER(Sub, T, C, Detail::Wrap<C>(Detail::Widen(x) - Detail::Widen(y)))                             \
+    WAFFLE_BINARY_HANDLER(Mul, T, C, Detail::Wrap<C>(Detail::Widen(x) * Detail::Widen(y)))                             \
+    WAFFLE_CHECKED_BINARY_HANDLER(Div, T, C, Detail::Div(x, y))                                                        \
+    WAFFLE_CHECKED_BINARY_HANDLER(Rem, T, C, Detail::Rem(x, y))                                                        \
+    WAFFLE_BINARY_HANDLER(And, T, C, static_cast<C>(x & y))                                                            \
+    WAFFLE_BINARY_HANDLER(Or, T, C, static_cast<C>(x | y))                                                             \
+    WAFFLE_BINARY_HANDLER(Xor, T, C, static_cast<C>(x ^ y))                                                            \
+    WAFFLE_BINARY_HANDLER(Shl, T, C, Detail::Wrap<C>(Detail::Widen(x) << Detail::ShiftCount(y)))                       \
+    WAFFLE_BINARY_HANDLER(Shr, T, C, static_cast<C>(x >> Detail::ShiftCount(y)))                                       \
+    WAFFLE_UNARY_HANDLER(Neg, T, C, Detail::Wrap<C>(0 - Detail::Widen(x)))                                             \
+    WAFFLE_UNARY_HANDLER(BitNot, T, C, Detail::Wrap<C>(~Detail::Widen(x)))                                             \
+    WAFFLE_UNARY_HANDLER(Cast, T, C, x)                                                                                \
+    WAFFLE_SATURATE_HANDLER(T, C)                                                                                      \
+    WAFFLE_UNARY_HANDLER(AddImm, T, C, Detail::Wrap<C>(Detail::Widen(x) + static_cast<std::int16_t>(ip->c)))           \
+    WAFFLE_COMPARE_HANDLERS(T, C)
+#define WAFFLE_FLOAT_HANDLERS(UNUSED, T, C)                                                                            \
+    WAFFLE_BINARY_HANDLER(Add, T, C, static_cast<C>(x + y))                                                            \
+    WAFFLE_BINARY_HANDLER(Sub, T, C, static_cast<C>(x - y))                                                            \
+    WAFFLE_BINARY_HANDLER(Mul, T, C, static_cast<C>(x * y))                                                            \
+    WAFFLE_BINARY_HANDLER(Div, T, C, static_cast<C>(x / y))                                                            \
+    WAFFLE_UNARY_HANDLER(Neg, T, C, static_cast<C>(-x))                                                                \
+    WAFFLE_COMPARE_HANDLERS(T, C)
+
+#if WAFFLE_COMPUTED_GOTO
+        WAFFLE_DISPATCH();
+#else
+    dispatch:
+        if constexpr (kCount) {
+            executed++;
+        }
+        switch (ip->op) {
+#endif
+
+        WAFFLE_HANDLER(Nop) { WAFFLE_NEXT(); }
+        WAFFLE_HANDLER(Move)
+        {
+            r[ip->a] = r[ip->b];
+            WAFFLE_NEXT();
+        }
+        WAFFLE_HANDLER(LoadImm)
+        {
+            r[ip->a] = Value::From(static_cast<std::int64_t>(ip->Imm()));
+            WAFFLE_NEXT();
+        }
+        WAFFLE_HANDLER(LoadConst)
+        {
+            r[ip->a].bits = module_.constants[static_cast<std::uint32_t>(ip->Imm())];
+            WAFFLE_NEXT();
+        }
+        WAFFLE_HANDLER(LoadString)
+        {
+            r[ip->a] = Value::From(module_.strings[static_cast<std::uint32_t>(ip->Imm())].c_str());
+            WAFFLE_NEXT();
+        }
+        WAFFLE_HANDLER(Not)
+        {
+            r[ip->a] = Value::From(r[ip->b].bits == 0);
+            WAFFLE_NEXT();
+        }
+        WAFFLE_HANDLER(Jump) { WAFFLE_JUMP(ip->Imm()); }
+        WAFFLE_HANDLER(JumpIfTrue) { WAFFLE_JUMP(r[ip->a].bits != 0 ? ip->Imm() : 0); }
+        WAFFLE_HANDLER(JumpIfFalse) { WAFFLE_JUMP(r[ip->a].bits == 0 ? ip->Imm() : 0); }
+        WAFFLE_HANDLER(Call)
+        {
+            // The callee's frame starts above all of the caller's registers, so none of them is clobbered
+            auto const &callee = module_.functions[ip->b];
+            auto const callee_base = base + frame_size;
+            if (frames_.size() >= kMaxCallDepth || !EnsureStack_(callee_base + callee.num_registers)) {
+                return trap("stack overflow");
+            }
+            r = registers_.data() + base;
+            std::copy_n(r + ip->a, ip->c, registers_.data() + callee_base);
+            frames_.push_back({ip + 1, base, frame_size, ip->a});
+            base = callee_base;
+            frame_size = callee.num_registers;
+            r = registers_.data() + base;
+            ip = callee.code.data();
+            WAFFLE_DISPATCH();
+        }
+        WAFFLE_HANDLER(CallExtern)
+        {
+            r[ip->a] = CallExtern(module_.externs[ip->b], r + ip->a);
+            WAFFLE_NEXT();
+        }
+        WAFFLE_HANDLER(Ret)
+        {
+            result = r[ip->a];
+            goto return_to_caller;
+        }
+        WAFFLE_HANDLER(RetVoid)
+        {
+            result = Value{};
+            goto return_to_caller;
+        }
+    return_to_caller:
+        {
+            if (frames_.empty()) {
+                instructions_executed_ += executed;
+                return result;
+            }
+            auto const frame = frames_.back();
+            frames_.pop_back();
+            base = frame.base;
+            frame_size = frame.size;
+            r = registers_.data() + base;
+            r[frame.result] = result;
+            ip = frame.return_ip;
+            WAFFLE_DISPATCH();
+        }
+        WAFFLE_CONVERSION_HANDLER(IToF_F32, std::int64_t, static_cast<float>(x))
+        WAFFLE_CONVERSION_HANDLER(IToF_F64, std::int64_t, static_cast<double>(x))
+        WAFFLE_CONVERSION_HANDLER(UToF_F32, std::uint64_t, static_cast<float>(x))
+        WAFFLE_CONVERSION_HANDLER(UToF_F64, std::uint64_t, static_cast<double>(x))
+        WAFFLE_CONVERSION_HANDLER(FToI_F32, float, Detail::SaturateToI64(x))
+        WAFFLE_CONVERSION_HANDLER(FToI_F64, double, Detail::SaturateToI64(x))
+        WAFFLE_CONVERSION_HANDLER(FToU_F32, float, Detail::SaturateToU64(x))
+        WAFFLE_CONVERSION_HANDLER(FToU_F64, double, Detail::SaturateToU64(x))
+        WAFFLE_CONVERSION_HANDLER(F32ToF64, float, static_cast<double>(x))
+        WAFFLE_CONVERSION_HANDLER(F64ToF32, double, static_cast<float>(x))
+
+        WAFFLE_INT_TYPES(WAFFLE_INT_HANDLERS, _)
+        WAFFLE_FLOAT_TYPES(WAFFLE_FLOAT_HANDLERS, _)
+
+#if !WAFFLE_COMPUTED_GOTO
+            case Opcode::Count: break;
+        }
+#endif
+        return trap("invalid opcode");
+    }
+
+} // namespace Bytecode
@@ -0,0 +1,327 @@
+#include <Bytecode/Module.h>
+
+#include <limits>
+
+namespace Bytecode
+{
+
+    namespace Detail
+    {
+        using Lexer::TokenKind;
+
+        // Typed opcodes of one operation are laid out in Type order, starting at the I8 or F32 variant
+        constexpr Opcode Typed(Opcode first, Type type)
+        {
+            auto const base = IsFloat(type) ? Type::F32 : Type::I8;
+            return static_cast<Opcode>(static_cast<int>(first) + static_cast<int>(type) - static_cast<int>(base));
+        }
+
+        struct BinaryOp
+        {
+            Opcode int_op;
+            std::optional<Opcode> float_op;
+            bool is_logical; // also defined for bool
+        };
+
+        std::optional<BinaryOp> LookupBinary(TokenKind op)
+        {
+            switch (op) {
+                case TokenKind::Plus:
+                case TokenKind::PlusEq: return BinaryOp{Opcode::Add_I8, Opcode::Add_F32, false};
+                case TokenKind::Minus:
+                case TokenKind::MinusEq: return BinaryOp{Opcode::Sub_I8, Opcode::Sub_F32, false};
+                case TokenKind::Star:
+                case TokenKind::StarEq: return BinaryOp{Opcode::Mul_I8, Opcode::Mul_F32, false};
+                case TokenKind::Slash:
+                case TokenKind::SlashEq: return BinaryOp{Opcode::Div_I8, Opcode::Div_F32, false};
+                case TokenKind::Percent:
+                case TokenKind::PercentEq: return BinaryOp{Opcode::Rem_I8, std::nullopt, false};
+                case TokenKind::LtLt:
+                case TokenKind::LtLtEq: return BinaryOp{Opcode::Shl_I8, std::nullopt, false};
+                case TokenKind::GtGt:
+                case TokenKind::GtGtEq: return BinaryOp{Opcode::Shr_I8, std::nullopt, false};
+                case TokenKind::Amp:
+                case TokenKind::AmpEq:
+                case TokenKind::AndAnd: return BinaryOp{Opcode::And_I8, std::nullopt, true};
+                case TokenKind::Pipe:
+                case TokenKind::PipeEq:
+                case TokenKind::OrOr: return BinaryOp{Opcode::Or_I8, std::nullopt, true};
+                case TokenKind::Caret:
+                case TokenKind::CaretEq: return BinaryOp{Opcode::Xor_I8, std::nullopt, true};
+                case TokenKind::EqEq: return BinaryOp{Opcode::Eq_I8, Opcode::Eq_F32, true};
+                case TokenKind::NotEq: return BinaryOp{Opcode::Ne_I8, Opcode::Ne_F32, true};
+                case TokenKind::Lt: return BinaryOp{Opcode::Lt_I8, Opcode::Lt_F32, false};
+                case TokenKind::LtEq: return BinaryOp{Opcode::Le_I8, Opcode::Le_F32, false};
+                case TokenKind::Gt: return BinaryOp{Opcode::Gt_I8, Opcode::Gt_F32, false};
+                case TokenKind::GtEq: return BinaryOp{Opcode::Ge_I8, Opcode::Ge_F32, false};
+                default: return std::nullopt;
+            }
+        }
+
+        struct BranchOp
+        {
+            Opcode int_op;
+            Opcode float_op;
+        };
+
+        std::optional<BranchOp> LookupBranch(TokenKind op)
+        {
+            switch (op) {
+                case TokenKind::EqEq: return BranchOp{Opcode::BrEq_I8, Opcode::BrEq_F32};
+                case TokenKind::NotEq: return BranchOp{Opcode::BrNe_I8, Opcode::BrNe_F32};
+                case TokenKind::Lt: return BranchOp{Opcode::BrLt_I8, Opcode::BrLt_F32};
+                case TokenKind::LtEq: return BranchOp{Opcode::BrLe_I8, Opcode::BrLe_F32};
+                case TokenKind::Gt: return BranchOp{Opcode::BrGt_I8, Opcode::BrGt_F32};
+                case TokenKind::GtEq: return BranchOp{Opcode::BrGe_I8, Opcode::BrGe_F32};
+                default: return std::nullopt;
+            }
+        }
+
+        constexpr int Width(Type type)
+        {
+            switch (type) {
+                case Type::I8:
+                case Type::U8: return 8;
+                case Type::I16:
+                case Type::U16: return 16;
+                case Type::I32:
+                case Type::U32: return 32;
+                default: return 64;
+            }
+        }
+    } // namespace Detail
+
+    std::uint32_t Module::AddConstant(Value value)
+    {
+        constants.push_back(value.bits);
+        return static_cast<std::uint32_t>(constants.size() - 1);
+    }
+
+    std::uint32_t Module::AddString(std::string_view text)
+    {
+        strings.emplace_back(text);
+        return static_cast<std::uint32_t>(strings.size() - 1);
+    }
+
+    std::uint32_t Module::AddExtern(ExternFunction function)
+    {
+        externs.push_back(std::move(function));
+        return static_cast<std::uint32_t>(externs.size() - 1);
+    }
+
+    std::optional<std::uint32_t> Module::FindFunction(std::string_view name) const
+    {
+        for (std::size_t i = 0; i < functions.size(); ++i) {
+            if (functions[i].name == name) {
+                return static_cast<std::uint32_t>(i);
+            }
+        }
+        return std::nullopt;
+    }
+
+    FunctionBuilder::FunctionBuilder(Module &module, std::string name, std::uint16_t num_params, Type ret)
+        : module_(module)
+        , function_{std::move(name), num_params, num_params, ret, {}}
+    {}
+
+    Reg FunctionBuilder::NewRegister() { return function_.num_registers++; }
+
+    Reg FunctionBuilder::NewRegisters(std::uint16_t count)
+    {
+        Reg first = function_.num_registers;
+        function_.num_registers += count;
+        return first;
+    }
+
+    Label FunctionBuilder::NewLabel()
+    {
+        labels_.emplace_back();
+        return {static_cast<std::uint32_t>(labels_.size() - 1)};
+    }
+
+    void FunctionBuilder::Bind(Label label) { labels_[label.id] = function_.code.size(); }
+
+    void FunctionBuilder::Emit(Opcode op, Reg a, std::uint16_t b, std::uint16_t c)
+    {
+        function_.code.push_back({op, a, b, c});
+    }
+
+    void FunctionBuilder::EmitImm(Opcode op, Reg a, std::int32_t imm)
+    {
+        function_.code.push_back(Instr::WithImm(op, a, imm));
+    }
+
+    void FunctionBuilder::EmitLoad(Reg a, Value value)
+    {
+        auto const as_signed = static_cast<std::int64_t>(value.bits);
+        if (as_signed >= std::numeric_limits<std::int32_t>::min() &&
+            as_signed <= std::numeric_limits<std::int32_t>::max()) {
+            EmitImm(Opcode::LoadImm, a, static_cast<std::int32_t>(as_signed));
+        }
+        else {
+            EmitImm(Opcode::LoadConst, a, static_cast<std::int32_t>(module_.AddConstant(value)));
+        }
+    }
+
+    void FunctionBuilder::EmitJump(Label target)
+    {
+        fixups_.push_back({function_.code.size(), target.id, true});
+        Emit(Opcode::Jump);
+    }
+
+    void FunctionBuilder::EmitJumpIf(bool condition, Reg a, Label target)
+    {
+        fixups_.push_back({function_.code.size(), target.id, true});
+        Emit(condition ? Opcode::JumpIfTrue : Opcode::JumpIfFalse, a);
+    }
+
+    void FunctionBuilder::EmitBranch(Opcode op, Reg a, Reg b, Label target)
+    {
+        fixups_.push_back({function_.code.size(), target.id, false});
+        Emit(op, a, b);
+    }
+
+    std::optional<std::uint32_t> FunctionBuilder::Finish(std::string &error)
+    {
+        for (auto const &fixup: fixups_) {
+            auto const &target = labels_[fixup.label];
+            if (!target) {
+                error = function_.name + ": jump to unbound label";
+                return std::nullopt;
+            }
+
+            auto offset = static_cast<std::int64_t>(*target) - static_cast<std::int64_t>(fixup.instr + 1);
+            auto &instr = function_.code[fixup.instr];
+            if (fixup.wide) {
+                instr = Instr::WithImm(instr.op, instr.a, static_cast<std::int32_t>(offset));
+            }
+            else if (offset < std::numeric_limits<std::int16_t>::min() ||
+                     offset > std::numeric_limits<std::int16_t>::max()) {
+                error = function_.name + ": branch offset out of range";
+                return std::nullopt;
+            }
+            else {
+                instr.c = static_cast<std::uint16_t>(static_cast<std::int16_t>(offset));
+            }
+        }
+
+        module_.functions.push_back(std::move(function_));
+        return static_cast<std::uint32_t>(module_.functions.size() - 1);
+    }
+
+    std::optional<Type> TypeFromToken(Lexer::TokenKind kind)
+    {
+        switch (kind) {
+            case Lexer::TokenKind::Void: return Type::Void;
+            case Lexer::TokenKind::Bool: return Type::Bool;
+            case Lexer::TokenKind::Int8: return Type::I8;
+            case Lexer::TokenKind::Int16: return Type::I16;
+            case Lexer::TokenKind::Int32: return Type::I32;
+            case Lexer::TokenKind::Int64: return Type::I64;
+            case Lexer::TokenKind::Uint8: return Type::U8;
+            case Lexer::TokenKind::Uint16: return Type::U16;
+            case Lexer::TokenKind::Uint32: return Type::U32;
+            case Lexer::TokenKind::Uint64: return Type::U64;
+            case Lexer::TokenKind::Fp32: return Type::F32;
+            case Lexer::TokenKind::Fp64: return Type::F64;
+            default: return std::nullopt;
+        }
+    }
+
+    std::optional<Opcode> SelectBinary(Lexer::TokenKind op, Type type)
+    {
+        auto binary = Detail::LookupBinary(op);
+        if (!binary) {
+            return std::nullopt;
+        }
+        if (type == Type::Bool) {
+            // Bools are 0 or 1, so the uint8 opcodes implement the logical operators
+            return binary->is_logical ? std::optional(Detail::Typed(binary->int_op, Type::U8)) : std::nullopt;
+        }
+        if (op == Lexer::TokenKind::AndAnd || op == Lexer::TokenKind::OrOr) {
+            return std::nullopt;
+        }
+        if (IsInteger(type)) {
+            return Detail::Typed(binary->int_op, type);
+        }
+        if (IsFloat(type) && binary->float_op) {
+            return Detail::Typed(*binary->float_op, type);
+        }
+        return std::nullopt;
+    }
+
+    std::optional<Opcode> SelectUnary(Lexer::TokenKind op, Type type)
+    {
+        switch (op) {
+            case Lexer::TokenKind::Plus:
+                return IsInteger(type) || IsFloat(type) ? std::optional(Opcode::Move) : std::nullopt;
+            case Lexer::TokenKind::Minus:
+                if (IsInteger(type)) {
+                    return Detail::Typed(Opcode::Neg_I8, type);
+                }
+                return IsFloat(type) ? std::optional(Detail::Typed(Opcode::Neg_F32, type)) : std::nullopt;
+            case Lexer::TokenKind::Tilde:
+                return IsInteger(type) ? std::optional(Detail::Typed(Opcode::BitNot_I8, type)) : std::nullopt;
+            case Lexer::TokenKind::Bang: return type == Type::Bool ? std::optional(Opcode::Not) : std::nullopt;
+            case Lexer::TokenKind::PlusPlus:
+            case Lexer::TokenKind::MinusMinus:
+                return IsInteger(type) ? std::optional(Detail::Typed(Opcode::AddImm_I8, type)) : std::nullopt;
+            default: return std::nullopt;
+        }
+    }
+
+    std::optional<Opcode> SelectBranch(Lexer::TokenKind op, Type type)
+    {
+        auto branch = Detail::LookupBranch(op);
+        if (!branch || !(IsInteger(type) || IsFloat(type) || type == Type::Bool)) {
+            return std::nullopt;
+        }
+        if (IsFloat(type)) {
+            return Detail::Typed(branch->float_op, type);
+        }
+        return Detail::Typed(branch->int_op, type == Type::Bool ? Type::U8 : type);
+    }
+
+    std::optional<std::vector<Opcode>> SelectConversion(Type from, Type to)
+    {
+        using Conversions = std::vector<Opcode>;
+        if (from == to) {
+            return Conversions{};
+        }
+
+        if (IsInteger(from) && IsInteger(to)) {
+            // Widening keeps the canonical representation unless it turns a negative value unsigned
+            bool const fits = Detail::Width(to) > Detail::Width(from) && (IsSigned(to) || !IsSigned(from));
+            return fits ? Conversions{} : Conversions{Detail::Typed(Opcode::Cast_I8, to)};
+        }
+        if (from == Type::Bool && IsInteger(to)) {
+            return Conversions{};
+        }
+        if (IsInteger(from) && IsFloat(to)) {
+            auto op = IsSigned(from) ? (to == Type::F32 ? Opcode::IToF_F32 : Opcode::IToF_F64)
+                                     : (to == Type::F32 ? Opcode::UToF_F32 : Opcode::UToF_F64);
+            return Conversions{op};
+        }
+        if (IsFloat(from) && IsInteger(to)) {
+            Conversions ops;
+            if (IsSigned(to)) {
+                ops.push_back(from == Type::F32 ? Opcode::FToI_F32 : Opcode::FToI_F64);
+            }
+            else {
+                ops.push_back(from == Type::F32 ? Opcode::FToU_F32 : Opcode::FToU_F64);
+            }
+            if (Detail::Width(to) < 64) {
+                ops.push_back(Detail::Typed(Opcode::Sat_I8, to));
+            }
+            return ops;
+        }
+        if (from == Type::F32 && to == Type::F64) {
+            return Conversions{Opcode::F32ToF64};
+        }
+        if (from == Type::F64 && to == Type::F32) {
+            return Conversions{Opcode::F64ToF32};
+        }
+        return std::nullopt;
+    }
+
+} // namespace Bytecode
@@ -0,0 +1,56 @@
+#include <Bytecode/Opcode.h>
+
+#include <array>
+
+namespace Bytecode
+{
+
+    namespace Detail
+    {
+        struct OpcodeInfo
+        {
+            std::string_view name;
+            Format format;
+        };
+
+#define WAFFLE_BASIC_INFO(NAME, FORMAT) {#NAME, Format::FORMAT},
+#define WAFFLE_TYPED_INFO_ABC(OP, T, C) {#OP "_" #T, Format::ABC},
+#define WAFFLE_TYPED_INFO_AB(OP, T, C) {#OP "_" #T, Format::AB},
+#define WAFFLE_TYPED_INFO_BRANCH(OP, T, C) {#OP "_" #T, Format::Branch},
+#define WAFFLE_TYPED_INFO_IMM(OP, T, C) {#OP "_" #T, Format::ABImm},
+#define WAFFLE_INT_INFO_ABC(OP) WAFFLE_INT_TYPES(WAFFLE_TYPED_INFO_ABC, OP)
+#define WAFFLE_INT_INFO_AB(OP) WAFFLE_INT_TYPES(WAFFLE_TYPED_INFO_AB, OP)
+#define WAFFLE_INT_INFO_BRANCH(OP) WAFFLE_INT_TYPES(WAFFLE_TYPED_INFO_BRANCH, OP)
+#define WAFFLE_FLOAT_INFO_ABC(OP) WAFFLE_FLOAT_TYPES(WAFFLE_TYPED_INFO_ABC, OP)
+#define WAFFLE_FLOAT_INFO_AB(OP) WAFFLE_FLOAT_TYPES(WAFFLE_TYPED_INFO_AB, OP)
+#define WAFFLE_FLOAT_INFO_BRANCH(OP) WAFFLE_FLOAT_TYPES(WAFFLE_TYPED_INFO_BRANCH, OP)
+
+        // Same order as the Opcode enumeration
+        constexpr OpcodeInfo kOpcodeInfo[] = {
+                WAFFLE_BASIC_OPS(WAFFLE_BASIC_INFO)
+                WAFFLE_INT_BINARY_OPS(WAFFLE_INT_INFO_ABC)
+                WAFFLE_COMPARE_OPS(WAFFLE_INT_INFO_ABC)
+                WAFFLE_BRANCH_OPS(WAFFLE_INT_INFO_BRANCH)
+                WAFFLE_INT_UNARY_OPS(WAFFLE_INT_INFO_AB)
+                WAFFLE_INT_TYPES(WAFFLE_TYPED_INFO_IMM, AddImm)
+                WAFFLE_FLOAT_BINARY_OPS(WAFFLE_FLOAT_INFO_ABC)
+                WAFFLE_COMPARE_OPS(WAFFLE_FLOAT_INFO_ABC)
+                WAFFLE_BRANCH_OPS(WAFFLE_FLOAT_INFO_BRANCH)
+                WAFFLE_FLOAT_UNARY_OPS(WAFFLE_FLOAT_INFO_AB)
+        };
+
+        static_assert(std::size(kOpcodeInfo) == static_cast<std::size_t>(Opcode::Count));
+
+        constexpr std::string_view kTypeNames[] = {"void", "bool",   "int8",   "int16", "int32", "int64", "uint8",
+                                                   "uint16", "uint32", "uint64", "fp32",  "fp64",  "ptr"};
+    } // namespace Detail
+
+    std::ostream &operator<<(std::ostream &os, Type type) { return os << Detail::kTypeNames[static_cast<int>(type)]; }
+
+    std::ostream &operator<<(std::ostream &os, Opcode op) { return os << OpcodeName(op); }
+
+    std::string_view OpcodeName(Opcode op) { return Detail::kOpcodeInfo[static_cast<std::size_t>(op)].name; }
+
+    Format OpcodeFormat(Opcode op) { return Detail::kOpcodeInfo[static_cast<std::size_t>(op)].format; }
+
+} // namespace Bytecode
@@ -0,0 +1,395 @@
+#include <Bytecode/Extern.h>
+#include <Bytecode/Interpreter.h>
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <limits>
+
+namespace
+{
+    using Bytecode::Opcode;
+    using Bytecode::Type;
+    using Bytecode::Value;
+    using Lexer::TokenKind;
+
+    // Builds `ret(op(p0, p1))` for one binary opcode
+    Bytecode::Module BinaryModule(Opcode op, Type type)
+    {
+        Bytecode::Module module;
+        Bytecode::FunctionBuilder fn(module, "binary", 2, type);
+        auto result = fn.NewRegister();
+        fn.Emit(op, result, fn.Param(0), fn.Param(1));
+        fn.Emit(Opcode::Ret, result);
+        std::string error;
+        EXPECT_TRUE(fn.Finish(error)) << error;
+        return module;
+    }
+
+    template<typename R, typename T>
+    std::optional<R> RunBinary(Opcode op, Type type, T x, T y, std::string &error)
+    {
+        auto interp = Bytecode::Interpreter::Create(BinaryModule(op, type), error);
+        if (!interp) {
+            return std::nullopt;
+        }
+        std::array args{Value::From(x), Value::From(y)};
+        auto result = interp->Call(0, args, error);
+        return result ? std::optional(result->template As<R>()) : std::nullopt;
+    }
+
+    // fib(n) = n < 2 ? n : fib(n - 1) + fib(n - 2), on int64
+    Bytecode::Module FibModule()
+    {
+        Bytecode::Module module;
+        Bytecode::FunctionBuilder fn(module, "fib", 1, Type::I64);
+        auto n = fn.Param(0);
+        auto two = fn.NewRegister();
+        auto lhs = fn.NewRegister();
+        auto rhs = fn.NewRegister();
+        auto recurse = fn.NewLabel();
+
+        fn.EmitLoad(two, Value::From<std::int64_t>(2));
+        fn.EmitBranch(*Bytecode::SelectBranch(TokenKind::GtEq, Type::I64), n, two, recurse);
+        fn.Emit(Opcode::Ret, n);
+        fn.Bind(recurse);
+        fn.Emit(Opcode::AddImm_I64, lhs, n, static_cast<std::uint16_t>(-1));
+        fn.Emit(Opcode::Call, lhs, 0, 1);
+        fn.Emit(Opcode::AddImm_I64, rhs, n, static_cast<std::uint16_t>(-2));
+        fn.Emit(Opcode::Call, rhs, 0, 1);
+        fn.Emit(Opcode::Add_I64, lhs, lhs, rhs);
+        fn.Emit(Opcode::Ret, lhs);
+
+        std::string error;
+        EXPECT_TRUE(fn.Finish(error)) << error;
+        return module;
+    }
+} // namespace
+
+//
+// Arithmetic
+//
+TEST(BytecodeArithmetic, WrapsAtTypeWidth)
+{
+    std::string error;
+    EXPECT_EQ(RunBinary<std::int64_t>(Opcode::Add_I8, Type::I8, 127, 1, error), -128);
+    EXPECT_EQ(RunBinary<std::uint64_t>(Opcode::Add_U8, Type::U8, 255, 1, error), 0u);
+    EXPECT_EQ(RunBinary<std::uint64_t>(Opcode::Sub_U32, Type::U32, 0, 1, error), 0xFFFFFFFFu);
+    EXPECT_EQ(RunBinary<std::int64_t>(Opcode::Mul_I16, Type::I16, 300, 300, error), static_cast<std::int16_t>(90000));
+    EXPECT_EQ(RunBinary<std::int64_t>(Opcode::Add_I64, Type::I64, std::numeric_limits<std::int64_t>::max(),
+                                      std::int64_t{1}, error),
+              std::numeric_limits<std::int64_t>::min());
+}
+
+TEST(BytecodeArithmetic, SignedAndUnsignedDiffer)
+{
+    std::string error;
+    EXPECT_EQ(RunBinary<std::int64_t>(Opcode::Div_I32, Type::I32, -7, 2, error), -3);
+    EXPECT_EQ(RunBinary<std::int64_t>(Opcode::Rem_I32, Type::I32, -7, 2, error), -1);
+    EXPECT_EQ(RunBinary<std::int64_t>(Opcode::Shr_I8, Type::I8, -128, 1, error), -64);
+    EXPECT_EQ(RunBinary<std::uint64_t>(Opcode::Shr_U8, Type::U8, 128, 1, error), 64u);
+    EXPECT_EQ(RunBinary<std::uint64_t>(Opcode::Lt_I32, Type::I32, -1, 1, error), 1u);
+    EXPECT_EQ(RunBinary<std::uint64_t>(Opcode::Lt_U32, Type::U32, std::uint32_t{0xFFFFFFFF}, std::uint32_t{1}, error),
+              0u);
+}
+
+TEST(BytecodeArithmetic, ShiftCountIsMasked)
+{
+    std::string error;
+    EXPECT_EQ(RunBinary<std::uint64_t>(Opcode::Shl_U8, Type::U8, 1, 9, error), 2u);
+    EXPECT_EQ(RunBinary<std::uint64_t>(Opcode::Shl_U64, Type::U64, std::uint64_t{1}, std::uint64_t{65}, error), 2u);
+}
+
+TEST(BytecodeArithmetic, DivisionByZeroTraps)
+{
+    std::string error;
+    EXPECT_FALSE(RunBinary<std::int64_t>(Opcode::Div_I32, Type::I32, 1, 0, error));
+    EXPECT_EQ(error, "division by zero");
+    EXPECT_FALSE(RunBinary<std::int64_t>(Opcode::Rem_U64, Type::U64, std::uint64_t{1}, std::uint64_t{0}, error));
+}
+
+TEST(BytecodeArithmetic, MinDividedByMinusOneWraps)
+{
+    std::string error;
+    EXPECT_EQ(RunBinary<std::int64_t>(Opcode::Div_I8, Type::I8, -128, -1, error), -128);
+    EXPECT_EQ(RunBinary<std::int64_t>(Opcode::Rem_I64, Type::I64, std::numeric_limits<std::int64_t>::min(),
+                                      std::int64_t{-1}, error),
+              0);
+}
+
+TEST(BytecodeArithmetic, FloatOps)
+{
+    std::string error;
+    EXPECT_EQ(RunBinary<float>(Opcode::Mul_F32, Type::F32, 1.5f, 4.0f, error), 6.0f);
+    EXPECT_EQ(RunBinary<double>(Opcode::Div_F64, Type::F64, 1.0, 4.0, error), 0.25);
+    EXPECT_EQ(RunBinary<std::uint64_t>(Opcode::Le_F64, Type::F64, 2.0, 2.0, error), 1u);
+}
+
+//
+// Conversions
+//
+TEST(BytecodeConversions, SelectsOpcodesPerTypePair)
+{
+    using Ops = std::vector<Opcode>;
+    EXPECT_EQ(Bytecode::SelectConversion(Type::I8, Type::I64), Ops{});
+    EXPECT_EQ(Bytecode::SelectConversion(Type::I8, Type::U64), Ops{Opcode::Cast_U64});
+    EXPECT_EQ(Bytecode::SelectConversion(Type::U32, Type::U16), Ops{Opcode::Cast_U16});
+    EXPECT_EQ(Bytecode::SelectConversion(Type::U8, Type::F64), Ops{Opcode::UToF_F64});
+    EXPECT_EQ(Bytecode::SelectConversion(Type::F32, Type::I8), (Ops{Opcode::FToI_F32, Opcode::Sat_I8}));
+    EXPECT_EQ(Bytecode::SelectConversion(Type::F32, Type::F64), Ops{Opcode::F32ToF64});
+    EXPECT_FALSE(Bytecode::SelectConversion(Type::F64, Type::Bool));
+}
+
+TEST(BytecodeConversions, FloatToIntSaturates)
+{
+    auto convert = [](Opcode op, double value) {
+        Bytecode::Module module;
+        Bytecode::FunctionBuilder fn(module, "convert", 1, Type::I64);
+        fn.Emit(op, 0, 0);
+        fn.Emit(Opcode::Ret, 0);
+        std::string error;
+        EXPECT_TRUE(fn.Finish(error));
+        auto interp = Bytecode::Interpreter::Create(std::move(module), error);
+        std::array args{Value::From(value)};
+        return interp->Call(0, args, error)->bits;
+    };
+
+    EXPECT_EQ(static_cast<std::int64_t>(convert(Opcode::FToI_F64, -2.5)), -2);
+    EXPECT_EQ(static_cast<std::int64_t>(convert(Opcode::FToI_F64, 1e30)), std::numeric_limits<std::int64_t>::max());
+    EXPECT_EQ(convert(Opcode::FToI_F64, std::numeric_limits<double>::quiet_NaN()), 0u);
+    EXPECT_EQ(convert(Opcode::FToU_F64, -1.0), 0u);
+    EXPECT_EQ(convert(Opcode::FToU_F64, 1e30), std::numeric_limits<std::uint64_t>::max());
+}
+
+TEST(BytecodeConversions, FloatToNarrowIntSaturates)
+{
+    auto convert = [](Type to, double value) {
+        Bytecode::Module module;
+        Bytecode::FunctionBuilder fn(module, "convert", 1, to);
+        auto const ops = Bytecode::SelectConversion(Type::F64, to);
+        for (auto op : *ops) {
+            fn.Emit(op, 0, 0);
+        }
+        fn.Emit(Opcode::Ret, 0);
+        std::string error;
+        EXPECT_TRUE(fn.Finish(error));
+        auto interp = Bytecode::Interpreter::Create(std::move(module), error);
+        std::array args{Value::From(value)};
+        return interp->Call(0, args, error)->bits;
+    };
+
+    EXPECT_EQ(static_cast<std::int64_t>(convert(Type::I8, 300.0)), 127);
+    EXPECT_EQ(static_cast<std::int64_t>(convert(Type::I8, -300.0)), -128);
+    EXPECT_EQ(static_cast<std::int64_t>(convert(Type::I16, -12.75)), -12);
+    EXPECT_EQ(static_cast<std::int64_t>(convert(Type::I32, 1e30)), std::numeric_limits<std::int32_t>::max());
+    EXPECT_EQ(convert(Type::U8, 300.0), 255u);
+    EXPECT_EQ(convert(Type::U16, -5.0), 0u);
+    EXPECT_EQ(convert(Type::U32, 1e30), std::numeric_limits<std::uint32_t>::max());
+}
+
+//
+// Opcode selection
+//
+TEST(BytecodeSelect, TypedOpcodes)
+{
+    EXPECT_EQ(Bytecode::SelectBinary(TokenKind::Plus, Type::I32), Opcode::Add_I32);
+    EXPECT_EQ(Bytecode::SelectBinary(TokenKind::StarEq, Type::F64), Opcode::Mul_F64);
+    EXPECT_EQ(Bytecode::SelectBinary(TokenKind::Lt, Type::U16), Opcode::Lt_U16);
+    EXPECT_EQ(Bytecode::SelectBinary(TokenKind::AndAnd, Type::Bool), Opcode::And_U8);
+    EXPECT_EQ(Bytecode::SelectUnary(TokenKind::PlusPlus, Type::U64), Opcode::AddImm_U64);
+    EXPECT_EQ(Bytecode::SelectBranch(TokenKind::NotEq, Type::F32), Opcode::BrNe_F32);
+    EXPECT_EQ(Bytecode::TypeFromToken(TokenKind::Uint16), Type::U16);
+}
+
+TEST(BytecodeSelect, RejectsUndefinedOperators)
+{
+    EXPECT_FALSE(Bytecode::SelectBinary(TokenKind::Percent, Type::F64));
+    EXPECT_FALSE(Bytecode::SelectBinary(TokenKind::Plus, Type::Bool));
+    EXPECT_FALSE(Bytecode::SelectBinary(TokenKind::AndAnd, Type::I32));
+    EXPECT_FALSE(Bytecode::SelectUnary(TokenKind::Tilde, Type::F32));
+    EXPECT_FALSE(Bytecode::SelectUnary(TokenKind::Bang, Type::I32));
+}
+
+//
+// Control flow
+//
+TEST(BytecodeControlFlow, SumLoop)
+{
+    // sum = 0; for (i = 0; i < n; ++i) sum += i;
+    Bytecode::Module module;
+    Bytecode::FunctionBuilder fn(module, "sum", 1, Type::I64);
+    auto sum = fn.NewRegister();
+    auto i = fn.NewRegister();
+    auto head = fn.NewLabel();
+    auto done = fn.NewLabel();
+    fn.EmitLoad(sum, Value::From<std::int64_t>(0));
+    fn.EmitLoad(i, Value::From<std::int64_t>(0));
+    fn.Bind(head);
+    fn.EmitBranch(Opcode::BrGe_I64, i, fn.Param(0), done);
+    fn.Emit(Opcode::Add_I64, sum, sum, i);
+    fn.Emit(Opcode::AddImm_I64, i, i, 1);
+    fn.EmitJump(head);
+    fn.Bind(done);
+    fn.Emit(Opcode::Ret, sum);
+
+    std::string error;
+    ASSERT_TRUE(fn.Finish(error)) << error;
+    auto interp = Bytecode::Interpreter::Create(std::move(module), error);
+    ASSERT_TRUE(interp) << error;
+
+    interp->SetCountInstructions(true);
+    std::array args{Value::From<std::int64_t>(1000)};
+    auto result = interp->Call(0, args, error);
+    ASSERT_TRUE(result) << error;
+    EXPECT_EQ(result->As<std::int64_t>(), 499500);
+    // Two loads, 1000 iterations of four instructions, the exit branch and the return
+    EXPECT_EQ(interp->InstructionsExecuted(), 2u + 4000u + 2u);
+}
+
+TEST(BytecodeControlFlow, RecursiveCalls)
+{
+    std::string error;
+    auto interp = Bytecode::Interpreter::Create(FibModule(), error);
+    ASSERT_TRUE(interp) << error;
+
+    std::array args{Value::From<std::int64_t>(20)};
+    auto result = interp->Call(0, args, error);
+    ASSERT_TRUE(result) << error;
+    EXPECT_EQ(result->As<std::int64_t>(), 6765);
+}
+
+TEST(BytecodeControlFlow, CallPreservesCallerRegisters)
+{
+    // overwrite(x) fills three registers with 100 and returns x
+    Bytecode::Module module;
+    Bytecode::FunctionBuilder callee(module, "overwrite", 1, Type::I64);
+    auto scratch = callee.NewRegisters(2);
+    callee.EmitLoad(scratch, Value::From<std::int64_t>(100));
+    callee.EmitLoad(scratch + 1, Value::From<std::int64_t>(100));
+    callee.Emit(Opcode::Ret, callee.Param(0));
+    std::string error;
+    ASSERT_TRUE(callee.Finish(error)) << error;
+
+    // A register above the argument window is still live after the call
+    Bytecode::FunctionBuilder caller(module, "caller", 0, Type::I64);
+    auto arg = caller.NewRegister();
+    auto live = caller.NewRegister();
+    caller.EmitLoad(arg, Value::From<std::int64_t>(1));
+    caller.EmitLoad(live, Value::From<std::int64_t>(42));
+    caller.Emit(Opcode::Call, arg, 0, 1);
+    caller.Emit(Opcode::Add_I64, live, live, arg);
+    caller.Emit(Opcode::Ret, live);
+    ASSERT_TRUE(caller.Finish(error)) << error;
+
+    auto interp = Bytecode::Interpreter::Create(std::move(module), error);
+    ASSERT_TRUE(interp) << error;
+    auto result = interp->Call(1, {}, error);
+    ASSERT_TRUE(result) << error;
+    EXPECT_EQ(result->As<std::int64_t>(), 43);
+}
+
+TEST(BytecodeControlFlow, UnboundedRecursionTraps)
+{
+    Bytecode::Module module;
+    Bytecode::FunctionBuilder fn(module, "forever", 0, Type::Void);
+    fn.Emit(Opcode::Call, fn.NewRegister(), 0, 0);
+    fn.Emit(Opcode::RetVoid);
+    std::string error;
+    ASSERT_TRUE(fn.Finish(error));
+
+    auto interp = Bytecode::Interpreter::Create(std::move(module), error);
+    ASSERT_TRUE(interp) << error;
+    EXPECT_FALSE(interp->Call(0, {}, error));
+    EXPECT_EQ(error, "stack overflow");
+}
+
+//
+// Verification
+//
+TEST(BytecodeVerify, RejectsBadOperands)
+{
+    auto expect_rejected = [](auto build) {
+        Bytecode::Module module;
+        Bytecode::FunctionBuilder fn(module, "bad", 1, Type::I64);
+        build(fn);
+        std::string error;
+        ASSERT_TRUE(fn.Finish(error)) << error;
+        EXPECT_FALSE(Bytecode::Interpreter::Create(std::move(module), error));
+        EXPECT_FALSE(error.empty());
+    };
+
+    // register out of range
+    expect_rejected([](auto &fn) { fn.Emit(Opcode::Ret, 5); });
+    // constant out of range
+    expect_rejected([](auto &fn) {
+        fn.EmitImm(Opcode::LoadConst, 0, 3);
+        fn.Emit(Opcode::Ret, 0);
+    });
+    // call with the wrong argument count
+    expect_rejected([](auto &fn) {
+        fn.Emit(Opcode::Call, 0, 0, 0);
+        fn.Emit(Opcode::Ret, 0);
+    });
+    // falls off the end
+    expect_rejected([](auto &fn) { fn.Emit(Opcode::Move, 0, 0); });
+}
+
+TEST(BytecodeVerify, RejectsUnboundLabel)
+{
+    Bytecode::Module module;
+    Bytecode::FunctionBuilder fn(module, "bad", 0, Type::Void);
+    fn.EmitJump(fn.NewLabel());
+    std::string error;
+    EXPECT_FALSE(fn.Finish(error));
+    EXPECT_EQ(error, "bad: jump to unbound label");
+}
+
+//
+// Extern calls
+//
+#if WAFFLE_EXTERN_BRIDGE_SUPPORTED
+TEST(BytecodeExtern, CallsLibc)
+{
+    // snprintf(buffer, size, "%s=%d %.2f", name, 42, 1.5), then strlen(buffer)
+    Bytecode::Module module;
+    auto snprintf = module.AddExtern({"snprintf",
+                                      {Type::Ptr, Type::U64, Type::Ptr, Type::Ptr, Type::I32, Type::F64},
+                                      3,
+                                      true,
+                                      Type::I32});
+    auto strlen = module.AddExtern({"strlen", {Type::Ptr}, 1, false, Type::U64});
+
+    Bytecode::FunctionBuilder fn(module, "format", 1, Type::U64);
+    auto args = fn.NewRegisters(6);
+    fn.Emit(Opcode::Move, args, fn.Param(0));
+    fn.EmitLoad(args + 1, Value::From<std::uint64_t>(64));
+    fn.EmitImm(Opcode::LoadString, args + 2, static_cast<std::int32_t>(module.AddString("%s=%d %.2f")));
+    fn.EmitImm(Opcode::LoadString, args + 3, static_cast<std::int32_t>(module.AddString("answer")));
+    fn.EmitLoad(args + 4, Value::From<std::int32_t>(42));
+    fn.EmitLoad(args + 5, Value::From(1.5));
+    fn.Emit(Opcode::CallExtern, args, static_cast<std::uint16_t>(snprintf), 6);
+    fn.Emit(Opcode::Move, args, fn.Param(0));
+    fn.Emit(Opcode::CallExtern, args, static_cast<std::uint16_t>(strlen), 1);
+    fn.Emit(Opcode::Ret, args);
+
+    std::string error;
+    ASSERT_TRUE(fn.Finish(error)) << error;
+    auto interp = Bytecode::Interpreter::Create(std::move(module), error);
+    ASSERT_TRUE(interp) << error;
+
+    char buffer[64] = {};
+    std::array call_args{Value::From(static_cast<char *>(buffer))};
+    auto result = interp->Call(0, call_args, error);
+    ASSERT_TRUE(result) << error;
+    EXPECT_STREQ(buffer, "answer=42 1.50");
+    EXPECT_EQ(result->As<std::uint64_t>(), std::strlen("answer=42 1.50"));
+}
+
+TEST(BytecodeExtern, UnknownSymbolFails)
+{
+    Bytecode::Module module;
+    module.AddExtern({"waffle_no_such_symbol", {}, 0, false, Type::Void});
+    std::string error;
+    EXPECT_FALSE(Bytecode::Interpreter::Create(std::move(module), error));
+    EXPECT_NE(error.find("waffle_no_such_symbol"), std::string::npos);
+}
+#endif
@@ -0,0 +1,63 @@
+#pragma once
+#include <Driver/Diagnostic.h>
+#include <Driver/InterfaceFile.h>
+#include <Driver/SourceCache.h>
+
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace Driver
+{
+
+    enum class Command
+    {
+        Check,
+        Build
+    };
+
+    struct RunOptions
+    {
+        Command command = Command::Check;
+        bool alloc_stats = false;
+        bool use_interfaces = true;
+    };
+
+    struct Result
+    {
+        bool ok = true;
+        std::vector<Diagnostic> diagnostics;
+        std::vector<std::string> notes;
+        std::size_t packages = 0;
+        std::size_t checked = 0; // packages lexed from source, the others came from their interface files
+        std::size_t files = 0;
+        CacheStats cache;
+        std::chrono::microseconds elapsed{0};
+    };
+
+    // Formats diagnostics and notes one per line, followed by a single summary line starting with "status".
+    std::string FormatResult(Result const &result);
+
+    // Front-end entry point shared by one-shot invocations and the daemon. The source cache and the opened interface
+    // files persist across runs, so a second run over unchanged packages only re-validates file stamps.
+    class Compiler
+    {
+    public:
+        explicit Compiler(std::vector<std::filesystem::path> search_paths = {});
+
+        Result Run(std::filesystem::path const &root, RunOptions const &options = {});
+
+        [[nodiscard]] SourceCache &Cache() { return cache_; }
+        [[nodiscard]] InterfaceCache &Interfaces() { return interfaces_; }
+
+    private:
+        std::vector<std::filesystem::path> search_paths_;
+        SourceCache cache_;
+        InterfaceCache interfaces_;
+    };
+
+    // Splits a colon separated list such as the WAFFLE_PATH environment variable.
+    std::vector<std::filesystem::path> ParseSearchPath(char const *value);
+
+} // namespace Driver
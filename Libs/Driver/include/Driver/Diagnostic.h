@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+
+namespace Driver
+{
+
+    struct Diagnostic
+    {
+        std::string file;
+        std::size_t offset = 0;
+        std::string message;
+    };
+
+    std::ostream &operator<<(std::ostream &os, Diagnostic const &diagnostic);
+
+} // namespace Driver
@@ -0,0 +1,81 @@
+#pragma once
+#include <Driver/Diagnostic.h>
+#include <Driver/SourceCache.h>
+#include <Lexer/Types.h>
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Driver
+{
+
+    enum class DeclKind : std::uint8_t
+    {
+        Func,
+        Extern
+    };
+
+    struct Param
+    {
+        Lexer::TokenKind type; // one of the primitive type keywords, Void..Fp64
+        bool is_mut = false;
+
+        bool operator==(Param const &) const = default;
+    };
+
+    struct Signature
+    {
+        DeclKind kind = DeclKind::Func;
+        std::string name;
+        std::string abi; // empty for the Waffle ABI, "C" for extern "C"
+        std::string mangled;
+        std::vector<Param> params;
+        Lexer::TokenKind ret = Lexer::TokenKind::Void;
+
+        bool operator==(Signature const &) const = default;
+    };
+
+    struct SourceRecord
+    {
+        std::string name; // file name inside the package directory
+        FileStamp stamp;
+        std::uint64_t hash = 0;
+    };
+
+    struct DependencyRecord
+    {
+        std::string package;
+        std::uint64_t interface_hash = 0;
+    };
+
+    // Everything a dependent package needs to know about a package: its public signatures. The sources and
+    // dependency records only serve to decide whether a stored interface is still up to date.
+    struct PackageInterface
+    {
+        std::string package;
+        std::vector<Signature> decls; // sorted by mangled name
+        std::vector<SourceRecord> sources;
+        std::vector<DependencyRecord> dependencies;
+
+        // Covers the public signatures only, so edits to function bodies or private functions keep it stable.
+        [[nodiscard]] std::uint64_t Hash() const;
+    };
+
+    [[nodiscard]] constexpr bool IsTypeKeyword(Lexer::TokenKind kind)
+    {
+        return kind >= Lexer::TokenKind::Void && kind <= Lexer::TokenKind::Fp64;
+    }
+
+    // External symbol name: `pkgid::name`, or the plain name for extern "C".
+    std::string MangleName(std::string_view package, std::string_view name, std::string_view abi);
+
+    // Appends the public FuncDef and ExternDecl signatures of a lexed file. Function bodies are skipped by brace
+    // matching, so this only relies on the top-level declaration syntax.
+    void ExtractSignatures(SourceFile const &file,
+                           std::string_view package,
+                           std::vector<Signature> &decls,
+                           std::vector<Diagnostic> &diagnostics);
+
+} // namespace Driver
@@ -0,0 +1,148 @@
+#pragma once
+#include <Driver/Interface.h>
+#include <Driver/SourceCache.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace Driver
+{
+
+    // On-disk layout of a package interface (.wfli). The file is mapped read-only and used in place, so every
+    // record is fixed size, naturally aligned and addressed by offsets from the start of the file. Integers are
+    // stored in host byte order. Bump kInterfaceVersion whenever a record or Lexer::TokenKind changes.
+    namespace Format
+    {
+        constexpr char kMagic[4] = {'W', 'F', 'L', 'I'};
+        constexpr std::uint32_t kInterfaceVersion = 1;
+
+        struct StringRef
+        {
+            std::uint32_t offset; // into the string table
+            std::uint32_t size;
+        };
+
+        struct Section
+        {
+            std::uint32_t offset; // from the start of the file
+            std::uint32_t count;
+        };
+
+        struct Header
+        {
+            char magic[4];
+            std::uint32_t version;
+            std::uint64_t interface_hash;
+            StringRef package;
+            Section decls;
+            Section params;
+            Section sources;
+            Section dependencies;
+            Section strings; // count is the size in bytes
+        };
+
+        struct DeclRecord
+        {
+            StringRef name;
+            StringRef abi;
+            StringRef mangled;
+            std::uint32_t first_param;
+            std::uint16_t param_count;
+            std::uint8_t kind;
+            std::uint8_t ret;
+        };
+
+        struct ParamRecord
+        {
+            std::uint8_t type;
+            std::uint8_t is_mut;
+        };
+
+        struct SourceRecord
+        {
+            StringRef name;
+            std::uint64_t size;
+            std::int64_t mtime; // file_time_type ticks
+            std::uint64_t hash;
+        };
+
+        struct DependencyRecord
+        {
+            StringRef package;
+            std::uint64_t interface_hash;
+        };
+    } // namespace Format
+
+    // Serializes `interface` and atomically replaces `path`; on failure returns false and sets `error`. The parent
+    // directory of `path` is created if missing, but not its ancestors.
+    bool WriteInterface(std::filesystem::path const &path, PackageInterface const &interface, std::string &error);
+
+    // A memory-mapped, validated interface file. Views returned by the accessors point into the mapping and stay
+    // valid for the lifetime of the object.
+    class InterfaceFile
+    {
+    public:
+        // Returns std::nullopt with `error` set when the file is missing, truncated or of another version.
+        static std::optional<InterfaceFile> Open(std::filesystem::path const &path, std::string &error);
+
+        InterfaceFile(InterfaceFile &&other) noexcept;
+        InterfaceFile &operator=(InterfaceFile &&other) noexcept;
+        ~InterfaceFile();
+
+        [[nodiscard]] std::uint64_t Hash() const { return Header_().interface_hash; }
+        [[nodiscard]] std::string_view Package() const { return String_(Header_().package); }
+
+        [[nodiscard]] std::span<Format::DeclRecord const> Decls() const;
+        [[nodiscard]] std::span<Format::SourceRecord const> Sources() const;
+        [[nodiscard]] std::span<Format::DependencyRecord const> Dependencies() const;
+        [[nodiscard]] std::span<Format::ParamRecord const> Params(Format::DeclRecord const &decl) const;
+        [[nodiscard]] std::string_view String(Format::StringRef ref) const { return String_(ref); }
+
+        // Copies the mapped data back into the in-memory representation.
+        [[nodiscard]] PackageInterface Load() const;
+
+    private:
+        InterfaceFile(void const *data, std::size_t size);
+
+        void const *data_ = nullptr;
+        std::size_t size_ = 0;
+
+        [[nodiscard]] Format::Header const &Header_() const { return *static_cast<Format::Header const *>(data_); }
+        [[nodiscard]] std::string_view String_(Format::StringRef ref) const;
+        template<typename T>
+        [[nodiscard]] std::span<T const> Section_(Format::Section section) const;
+        [[nodiscard]] bool Validate_(std::string &error) const;
+    };
+
+    // Keeps interface files mapped between package graph loads, so a long-lived compiler does not reopen and
+    // revalidate them on every run. A file is reopened when its stamp changes.
+    class InterfaceCache
+    {
+    public:
+        // Returns nullptr with `error` set when the file cannot be opened, see InterfaceFile::Open.
+        InterfaceFile const *Open(std::filesystem::path const &path, std::string &error);
+
+        [[nodiscard]] std::size_t Size() const { return files_.size(); }
+        // Opens served without touching the file's contents, since construction
+        [[nodiscard]] std::size_t Hits() const { return hits_; }
+
+    private:
+        struct Entry
+        {
+            FileStamp stamp;
+            InterfaceFile file;
+        };
+
+        std::unordered_map<std::string, Entry> files_;
+        std::size_t hits_ = 0;
+    };
+
+    // Location of the interface file for the package in `package_dir`.
+    [[nodiscard]] std::filesystem::path InterfacePath(std::filesystem::path const &package_dir);
+
+} // namespace Driver
@@ -0,0 +1,58 @@
+#pragma once
+#include <Driver/Diagnostic.h>
+#include <Driver/Interface.h>
+#include <Driver/InterfaceFile.h>
+#include <Driver/SourceCache.h>
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace Driver
+{
+
+    struct UseDecl
+    {
+        std::string package; // dotted package id, e.g. "lib.io"
+        std::string file;
+        std::size_t offset = 0;
+    };
+
+    struct Package
+    {
+        std::string id;
+        std::filesystem::path dir;
+        std::vector<SourceFile const *> files; // empty unless the package was checked from source
+        std::vector<UseDecl> uses;
+        PackageInterface interface;
+        std::uint64_t interface_hash = 0;
+        bool checked = false;
+    };
+
+    struct LoadOptions
+    {
+        std::vector<std::filesystem::path> search_paths;
+        // Read and write per-package interface files. A package whose sources are unchanged and whose dependencies
+        // still have the interface hashes it was checked against is taken from its interface file without lexing.
+        bool use_interfaces = false;
+        // Keeps interface files open across loads; without one they are opened for this load only.
+        InterfaceCache *interfaces = nullptr;
+    };
+
+    struct PackageGraph
+    {
+        std::vector<Package> packages; // topological order, dependencies first
+        std::vector<Diagnostic> diagnostics;
+    };
+
+    // Collects the `use` declarations at the top level of a lexed file.
+    std::vector<UseDecl> CollectUses(SourceFile const &file);
+
+    // Loads the package rooted at `root` and every package it transitively uses. `root` is either a package
+    // directory or a single source file, which then forms its directory's package on its own and is always checked
+    // from source, without reading or writing the directory's interface file. `use a.b` resolves to
+    // the directory `a/b` below the root package's parent directory or below one of the search paths. A root that
+    // does not exist or holds no source files yields an empty graph with a diagnostic.
+    PackageGraph LoadPackageGraph(SourceCache &cache, std::filesystem::path const &root, LoadOptions const &options);
+
+} // namespace Driver
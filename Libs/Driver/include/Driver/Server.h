@@ -0,0 +1,61 @@
+#pragma once
+#include <Driver/Compiler.h>
+
+#include <chrono>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Driver
+{
+
+    // Requests and responses are plain text over a Unix domain socket, one exchange per connection. A request is a
+    // command line ("check", "build", "stats" or "shutdown") followed by one argument per line and an empty line:
+    //
+    //     check\n--alloc-stats\n/abs/path/to/package\n\n
+    //
+    // check and build accept the --alloc-stats and --no-interfaces flags of the command line driver.
+    //
+    // The response is the output of FormatResult(), ending in the "status" line.
+    std::string EncodeRequest(std::string_view command, std::vector<std::string> const &args);
+
+    [[nodiscard]] std::filesystem::path DefaultSocketPath();
+
+    class Server
+    {
+    public:
+        Server(std::filesystem::path socket_path, std::vector<std::filesystem::path> search_paths = {});
+        ~Server();
+
+        Server(Server const &) = delete;
+        Server &operator=(Server const &) = delete;
+
+        // Binds and listens on the socket; on failure returns false and describes the problem in `error`. Fails if
+        // another server is listening on the path or something other than a socket is there; only a stale socket
+        // file from a server that is gone is replaced.
+        bool Listen(std::string &error);
+        // Services requests one at a time until a shutdown request arrives. A client that has not sent its whole
+        // request within the request timeout is disconnected without a response.
+        void Serve();
+        void SetRequestTimeout(std::chrono::milliseconds timeout) { request_timeout_ = timeout; }
+
+        // Handles a single decoded request; exposed for testing.
+        std::string Handle(std::string_view request);
+
+    private:
+        std::filesystem::path socket_path_;
+        Compiler compiler_;
+        int fd_ = -1;
+        bool running_ = false;
+        std::chrono::milliseconds request_timeout_ = std::chrono::seconds(5);
+    };
+
+    // Sends a request to a running server and returns its response, or std::nullopt with `error` set when the
+    // server cannot be reached.
+    std::optional<std::string> SendRequest(std::filesystem::path const &socket_path,
+                                           std::string_view request,
+                                           std::string &error);
+
+} // namespace Driver
@@ -0,0 +1,105 @@
+#pragma once
+#include <Driver/SymbolTable.h>
+#include <Lexer/Types.h>
+#include <Lexer/Unicode.h>
+#include <Memory/Arena.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace Driver
+{
+
+    struct FileStamp
+    {
+        std::filesystem::file_time_type mtime;
+        std::uintmax_t size = 0;
+
+        bool operator==(FileStamp const &) const = default;
+    };
+
+    // Size and mtime of a file; std::nullopt when it does not exist or cannot be read.
+    std::optional<FileStamp> StatFile(std::filesystem::path const &path);
+
+    constexpr std::uint64_t kHashSeed = 0xcbf29ce484222325ull;
+
+    // FNV-1a; pass a previous result as `seed` to hash several pieces as one stream.
+    std::uint64_t HashContents(std::string_view contents, std::uint64_t seed = kHashSeed);
+    // Hashes a file's contents without caching them; std::nullopt when it cannot be read.
+    std::optional<std::uint64_t> HashFile(std::filesystem::path const &path);
+
+    // A source file together with everything the front end derived from it. All of it lives in the file's arena,
+    // so invalidating an entry is a single release.
+    struct SourceFile
+    {
+        std::filesystem::path path;
+        FileStamp stamp;
+        std::uint64_t hash = 0;
+
+        std::unique_ptr<Memory::FileArena> arena;
+        Memory::CountingResource lex_phase;
+        std::pmr::string contents;
+        std::optional<Lexer::Utf8Error> utf8_error; // an ill-formed file is not lexed and has no tokens
+        std::pmr::vector<Lexer::Token> tokens;
+        std::pmr::vector<SymbolId> symbols; // one per token, kNoSymbol unless the token is an identifier
+        std::uint64_t last_run = 0;         // the SourceCache run that last returned this entry
+
+        SourceFile(std::filesystem::path path, FileStamp stamp, std::size_t size);
+    };
+
+    struct CacheStats
+    {
+        std::size_t hits = 0;
+        std::size_t stamp_refreshes = 0;
+        std::size_t lexed = 0;
+        std::size_t evicted = 0;
+    };
+
+    // Keeps lexed source files in memory between compilations. An entry is reused while the file's size and mtime
+    // are unchanged; a changed stamp with identical contents only refreshes the stamp. A long-lived owner brackets
+    // each compilation with BeginRun() and EvictUnused(), so entries of deleted or no longer compiled files go away.
+    class SourceCache
+    {
+    public:
+        // Entries unused for this many runs are evicted, so a daemon alternating between a few projects keeps all
+        // of them warm.
+        static constexpr std::uint64_t kMaxIdleRuns = 8;
+
+        // Returns nullptr when the file cannot be read.
+        SourceFile const *Get(std::filesystem::path const &path);
+        // Counts the entry of a file as used by the current run without returning it, for packages taken from their
+        // interface files. Only an entry that is still current counts, as a hit.
+        void MarkUsed(std::filesystem::path const &path);
+        void Invalidate(std::filesystem::path const &path);
+        void Clear();
+
+        // Starts a run; entries returned by Get() from now on count as used by it.
+        void BeginRun() { run_++; }
+        // Drops entries whose file no longer exists or that the last kMaxIdleRuns runs did not use. Counts the
+        // dropped entries in Stats().
+        void EvictUnused();
+
+        [[nodiscard]] std::size_t Size() const { return files_.size(); }
+        [[nodiscard]] CacheStats const &Stats() const { return stats_; }
+        void ResetStats() { stats_ = {}; }
+
+        [[nodiscard]] SymbolTable &Symbols() { return symbols_; }
+        [[nodiscard]] SymbolTable const &Symbols() const { return symbols_; }
+
+    private:
+        SymbolTable symbols_;
+        std::unordered_map<std::string, std::unique_ptr<SourceFile>> files_;
+        CacheStats stats_;
+        std::uint64_t run_ = 0;
+
+        std::unique_ptr<SourceFile> Load_(std::filesystem::path const &path, FileStamp stamp);
+        void Release_(SourceFile const &file);
+    };
+
+} // namespace Driver
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <memory_resource>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace Driver
+{
+
+    using SymbolId = std::uint32_t;
+
+    constexpr SymbolId kNoSymbol = UINT32_MAX;
+
+    // Interns identifier spellings into dense ids. Every Intern() takes a reference that Release() gives back; a
+    // name and its id stay valid while referenced, after that the id may be reused for another name. Names are
+    // copied into a pool owned by the table, so a long-lived table only holds the names still in use.
+    class SymbolTable
+    {
+    public:
+        SymbolId Intern(std::string_view name);
+        void Release(SymbolId id);
+        [[nodiscard]] SymbolId Find(std::string_view name) const;
+        [[nodiscard]] std::string_view Name(SymbolId id) const { return names_[id]; }
+        // Number of names currently referenced
+        [[nodiscard]] std::size_t Size() const { return names_.size() - free_.size(); }
+        void Clear();
+
+    private:
+        std::pmr::unsynchronized_pool_resource storage_;
+        std::unordered_map<std::string_view, SymbolId> ids_;
+        std::vector<std::string_view> names_;
+        std::vector<std::uint32_t> references_;
+        std::vector<SymbolId> free_;
+    };
+
+} // namespace Driver
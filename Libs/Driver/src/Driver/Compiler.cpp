@@ -0,0 +1,91 @@
+#include <Driver/Compiler.h>
+#include <Driver/Package.h>
+
+#include <sstream>
+#include <string_view>
+
+namespace Driver
+{
+
+    std::string FormatResult(Result const &result)
+    {
+        std::ostringstream os;
+        for (auto const &diagnostic: result.diagnostics) {
+            os << diagnostic << "\n";
+        }
+        for (auto const &note: result.notes) {
+            os << note << "\n";
+        }
+        os << "status " << (result.ok ? "ok" : "error") << " packages=" << result.packages
+           << " checked=" << result.checked << " files=" << result.files << " lexed=" << result.cache.lexed
+           << " reused=" << result.cache.hits << " refreshed=" << result.cache.stamp_refreshes
+           << " evicted=" << result.cache.evicted << " elapsed_us=" << result.elapsed.count() << "\n";
+        return os.str();
+    }
+
+    Compiler::Compiler(std::vector<std::filesystem::path> search_paths) : search_paths_(std::move(search_paths)) {}
+
+    Result Compiler::Run(std::filesystem::path const &root, RunOptions const &options)
+    {
+        auto const start = std::chrono::steady_clock::now();
+        cache_.ResetStats();
+        cache_.BeginRun();
+
+        Result result;
+        auto graph = LoadPackageGraph(cache_, root, {search_paths_, options.use_interfaces, &interfaces_});
+        result.diagnostics = std::move(graph.diagnostics);
+        result.packages = graph.packages.size();
+
+        for (auto const &package: graph.packages) {
+            result.checked += package.checked ? 1 : 0;
+            for (auto const *file: package.files) {
+                result.files++;
+                if (file->utf8_error) {
+                    result.diagnostics.push_back(
+                            {file->path.string(), file->utf8_error->offset, file->utf8_error->message});
+                }
+                for (auto const &token: file->tokens) {
+                    if (token.kind == Lexer::TokenKind::Error) {
+                        result.diagnostics.push_back({std::string(token.span.file), token.span.start,
+                                                      "unexpected '" + std::string(token.lexeme) + "'"});
+                    }
+                }
+
+                if (options.alloc_stats) {
+                    std::ostringstream note;
+                    note << file->path.string() << ": lex: " << file->lex_phase.Stats() << "\n"
+                         << file->path.string() << ": upstream: " << file->arena->UpstreamStats();
+                    result.notes.push_back(note.str());
+                }
+            }
+        }
+
+        // Code generation is not implemented yet, so a build stops after the front end like a check does.
+        result.ok = result.diagnostics.empty();
+        cache_.EvictUnused();
+        result.cache = cache_.Stats();
+        auto const elapsed = std::chrono::steady_clock::now() - start;
+        result.elapsed = std::chrono::duration_cast<std::chrono::microseconds>(elapsed);
+        return result;
+    }
+
+    std::vector<std::filesystem::path> ParseSearchPath(char const *value)
+    {
+        std::vector<std::filesystem::path> paths;
+        if (!value) {
+            return paths;
+        }
+
+        std::string_view rest(value);
+        while (!rest.empty()) {
+            auto end = rest.find(':');
+            auto entry = rest.substr(0, end);
+            if (!entry.empty()) {
+                paths.emplace_back(entry);
+            }
+            rest = end == std::string_view::npos ? std::string_view() : rest.substr(end + 1);
+        }
+        return paths;
+    }
+
+} // namespace Driver
@@ -0,0 +1,9 @@
+#include <Driver/Diagnostic.h>
+
+namespace Driver
+{
+    std::ostream &operator<<(std::ostream &os, Diagnostic const &diagnostic)
+    {
+        return os << diagnostic.file << ":" << diagnostic.offset << ": error: " << diagnostic.message;
+    }
+} // namespace Driver
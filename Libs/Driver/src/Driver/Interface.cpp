@@ -0,0 +1,205 @@
+#include <Driver/Interface.h>
+
+namespace Driver
+{
+
+    namespace Detail
+    {
+        using Lexer::TokenKind;
+
+        class SignatureScanner
+        {
+        public:
+            SignatureScanner(SourceFile const &file,
+                             std::string_view package,
+                             std::vector<Signature> &decls,
+                             std::vector<Diagnostic> &diagnostics)
+                : file_(file)
+                , tokens_(file.tokens)
+                , package_(package)
+                , decls_(decls)
+                , diagnostics_(diagnostics)
+            {}
+
+            void Scan()
+            {
+                while (Kind_() != TokenKind::Eof) {
+                    switch (Kind_()) {
+                        case TokenKind::Public:
+                        case TokenKind::Func:
+                        case TokenKind::Extern: ScanDecl_(); break;
+                        case TokenKind::LBrace: SkipBlock_(); break;
+                        default: pos_++; break;
+                    }
+                }
+            }
+
+        private:
+            SourceFile const &file_;
+            std::pmr::vector<Lexer::Token> const &tokens_;
+            std::string_view package_;
+            std::vector<Signature> &decls_;
+            std::vector<Diagnostic> &diagnostics_;
+            std::size_t pos_ = 0;
+
+            [[nodiscard]] TokenKind Kind_(std::size_t lookahead = 0) const
+            {
+                auto index = pos_ + lookahead;
+                return index < tokens_.size() ? tokens_[index].kind : TokenKind::Eof;
+            }
+
+            bool Expect_(TokenKind kind, std::string_view what)
+            {
+                if (Kind_() == kind) {
+                    pos_++;
+                    return true;
+                }
+                Error_(what);
+                return false;
+            }
+
+            // Reports that `what` was expected at the current token
+            void Error_(std::string_view what)
+            {
+                auto offset = pos_ < tokens_.size() ? tokens_[pos_].span.start : 0;
+                diagnostics_.push_back({file_.path.string(), offset, "expected " + std::string(what)});
+            }
+
+            void SkipBlock_()
+            {
+                std::size_t depth = 0;
+                do {
+                    if (Kind_() == TokenKind::LBrace) {
+                        depth++;
+                    }
+                    else if (Kind_() == TokenKind::RBrace) {
+                        depth--;
+                    }
+                    pos_++;
+                }
+                while (depth > 0 && Kind_() != TokenKind::Eof);
+            }
+
+            void ScanDecl_()
+            {
+                Signature decl;
+                bool const is_public = Kind_() == TokenKind::Public;
+                if (is_public) {
+                    pos_++;
+                }
+
+                if (Kind_() == TokenKind::Extern) {
+                    decl.kind = DeclKind::Extern;
+                    pos_++;
+                    if (Kind_() == TokenKind::StringLiteral) {
+                        std::string_view literal = tokens_[pos_].lexeme;
+                        decl.abi = literal.substr(1, literal.size() - 2);
+                        pos_++;
+                    }
+                }
+
+                if (!Expect_(TokenKind::Func, "'func'")) {
+                    return;
+                }
+                if (Kind_() == TokenKind::Ident) {
+                    decl.name = std::string_view(tokens_[pos_].lexeme);
+                }
+                if (!Expect_(TokenKind::Ident, "function name") || !Expect_(TokenKind::LParen, "'('")) {
+                    return;
+                }
+
+                while (Kind_() != TokenKind::RParen) {
+                    Param param{TokenKind::Void};
+                    if (Kind_() == TokenKind::Mut) {
+                        param.is_mut = true;
+                        pos_++;
+                    }
+                    if (!IsTypeKeyword(Kind_())) {
+                        Error_("parameter type");
+                        return;
+                    }
+                    param.type = Kind_();
+                    pos_++;
+                    if (Kind_() == TokenKind::Ident) {
+                        pos_++;
+                    }
+                    decl.params.push_back(param);
+                    if (Kind_() != TokenKind::Comma) {
+                        break;
+                    }
+                    pos_++;
+                }
+                if (!Expect_(TokenKind::RParen, "')'")) {
+                    return;
+                }
+
+                if (!IsTypeKeyword(Kind_())) {
+                    Error_("return type");
+                    return;
+                }
+                decl.ret = Kind_();
+                pos_++;
+
+                if (decl.kind == DeclKind::Extern) {
+                    if (!Expect_(TokenKind::Semicolon, "';'")) {
+                        return;
+                    }
+                }
+                else if (Kind_() == TokenKind::LBrace) {
+                    SkipBlock_();
+                }
+                else {
+                    Error_("function body");
+                    return;
+                }
+
+                if (is_public) {
+                    decl.mangled = MangleName(package_, decl.name, decl.abi);
+                    decls_.push_back(std::move(decl));
+                }
+            }
+        };
+    } // namespace Detail
+
+    std::uint64_t PackageInterface::Hash() const
+    {
+        auto mix = [](std::uint64_t hash, auto value) {
+            return HashContents(std::string_view(reinterpret_cast<char const *>(&value), sizeof(value)), hash);
+        };
+        // Strings are length-prefixed so ("ab", "c") and ("a", "bc") hash differently
+        auto mix_string = [&](std::uint64_t hash, std::string_view text) {
+            return HashContents(text, mix(hash, static_cast<std::uint64_t>(text.size())));
+        };
+
+        auto hash = mix_string(kHashSeed, package);
+        for (auto const &decl: decls) {
+            hash = mix(hash, static_cast<std::uint8_t>(decl.kind));
+            hash = mix_string(hash, decl.mangled);
+            hash = mix_string(hash, decl.abi);
+            hash = mix(hash, static_cast<std::uint8_t>(decl.ret));
+            hash = mix(hash, static_cast<std::uint64_t>(decl.params.size()));
+            for (auto const &param: decl.params) {
+                hash = mix(hash, static_cast<std::uint8_t>(param.type));
+                hash = mix(hash, static_cast<std::uint8_t>(param.is_mut));
+            }
+        }
+        return hash;
+    }
+
+    std::string MangleName(std::string_view package, std::string_view name, std::string_view abi)
+    {
+        if (abi == "C") {
+            return std::string(name);
+        }
+        return std::string(package) + "::" + std::string(name);
+    }
+
+    void ExtractSignatures(SourceFile const &file,
+                           std::string_view package,
+                           std::vector<Signature> &decls,
+                           std::vector<Diagnostic> &diagnostics)
+    {
+        Detail::SignatureScanner(file, package, decls, diagnostics).Scan();
+    }
+
+} // namespace Driver
@@ -0,0 +1,342 @@
+#include <Driver/InterfaceFile.h>
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Driver
+{
+
+    namespace Detail
+    {
+        static_assert(std::is_trivially_copyable_v<Format::Header> && sizeof(Format::Header) == 64);
+        static_assert(std::is_trivially_copyable_v<Format::DeclRecord> && sizeof(Format::DeclRecord) == 32);
+        static_assert(std::is_trivially_copyable_v<Format::SourceRecord> && sizeof(Format::SourceRecord) == 32);
+        static_assert(std::is_trivially_copyable_v<Format::DependencyRecord> &&
+                      sizeof(Format::DependencyRecord) == 16);
+        static_assert(std::is_trivially_copyable_v<Format::ParamRecord> && sizeof(Format::ParamRecord) == 2);
+
+        constexpr std::size_t kSectionAlignment = 8;
+
+        class Builder
+        {
+        public:
+            Format::StringRef AddString(std::string_view text)
+            {
+                Format::StringRef ref{static_cast<std::uint32_t>(strings_.size()),
+                                      static_cast<std::uint32_t>(text.size())};
+                strings_.append(text);
+                return ref;
+            }
+
+            template<typename T>
+            Format::Section AddSection(std::vector<T> const &records)
+            {
+                Align_();
+                Format::Section section{static_cast<std::uint32_t>(bytes_.size()),
+                                        static_cast<std::uint32_t>(records.size())};
+                auto const *data = reinterpret_cast<char const *>(records.data());
+                bytes_.insert(bytes_.end(), data, data + records.size() * sizeof(T));
+                return section;
+            }
+
+            Format::Section AddStrings()
+            {
+                Align_();
+                Format::Section section{static_cast<std::uint32_t>(bytes_.size()),
+                                        static_cast<std::uint32_t>(strings_.size())};
+                bytes_.insert(bytes_.end(), strings_.begin(), strings_.end());
+                return section;
+            }
+
+            std::vector<char> Finish(Format::Header const &header)
+            {
+                std::memcpy(bytes_.data(), &header, sizeof(header));
+                return std::move(bytes_);
+            }
+
+        private:
+            std::vector<char> bytes_ = std::vector<char>(sizeof(Format::Header));
+            std::string strings_;
+
+            void Align_()
+            {
+                bytes_.resize((bytes_.size() + kSectionAlignment - 1) / kSectionAlignment * kSectionAlignment);
+            }
+        };
+    } // namespace Detail
+
+    bool WriteInterface(std::filesystem::path const &path, PackageInterface const &interface, std::string &error)
+    {
+        Detail::Builder builder;
+        Format::Header header{};
+        std::memcpy(header.magic, Format::kMagic, sizeof(header.magic));
+        header.version = Format::kInterfaceVersion;
+        header.interface_hash = interface.Hash();
+        header.package = builder.AddString(interface.package);
+
+        std::vector<Format::DeclRecord> decls;
+        std::vector<Format::ParamRecord> params;
+        for (auto const &decl: interface.decls) {
+            decls.push_back({builder.AddString(decl.name), builder.AddString(decl.abi), builder.AddString(decl.mangled),
+                             static_cast<std::uint32_t>(params.size()), static_cast<std::uint16_t>(decl.params.size()),
+                             static_cast<std::uint8_t>(decl.kind), static_cast<std::uint8_t>(decl.ret)});
+            for (auto const &param: decl.params) {
+                params.push_back({static_cast<std::uint8_t>(param.type), static_cast<std::uint8_t>(param.is_mut)});
+            }
+        }
+
+        std::vector<Format::SourceRecord> sources;
+        for (auto const &source: interface.sources) {
+            sources.push_back({builder.AddString(source.name), source.stamp.size,
+                               static_cast<std::int64_t>(source.stamp.mtime.time_since_epoch().count()), source.hash});
+        }
+
+        std::vector<Format::DependencyRecord> dependencies;
+        for (auto const &dependency: interface.dependencies) {
+            dependencies.push_back({builder.AddString(dependency.package), dependency.interface_hash});
+        }
+
+        header.decls = builder.AddSection(decls);
+        header.params = builder.AddSection(params);
+        header.sources = builder.AddSection(sources);
+        header.dependencies = builder.AddSection(dependencies);
+        header.strings = builder.AddStrings();
+        auto bytes = builder.Finish(header);
+
+        // Only the innermost directory (`.waffle`) is created, a missing package directory is an error
+        std::error_code ec;
+        std::filesystem::create_directory(path.parent_path(), ec);
+        if (ec) {
+            error = "cannot create " + path.parent_path().string() + ": " + ec.message();
+            return false;
+        }
+        auto temporary = path;
+        temporary += ".tmp";
+        {
+            std::ofstream output(temporary, std::ios::binary | std::ios::trunc);
+            output.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+            if (!output) {
+                error = "cannot write " + temporary.string();
+                return false;
+            }
+        }
+        std::filesystem::rename(temporary, path, ec);
+        if (ec) {
+            error = "cannot replace " + path.string() + ": " + ec.message();
+            return false;
+        }
+        return true;
+    }
+
+    std::optional<InterfaceFile> InterfaceFile::Open(std::filesystem::path const &path, std::string &error)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            error = path.string() + ": " + std::strerror(errno);
+            return std::nullopt;
+        }
+
+        struct stat info{};
+        if (::fstat(fd, &info) < 0 || static_cast<std::size_t>(info.st_size) < sizeof(Format::Header)) {
+            error = path.string() + ": truncated interface file";
+            ::close(fd);
+            return std::nullopt;
+        }
+
+        auto size = static_cast<std::size_t>(info.st_size);
+        void *data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (data == MAP_FAILED) {
+            error = path.string() + ": " + std::strerror(errno);
+            return std::nullopt;
+        }
+
+        InterfaceFile file(data, size);
+        if (!file.Validate_(error)) {
+            error = path.string() + ": " + error;
+            return std::nullopt;
+        }
+        return file;
+    }
+
+    InterfaceFile::InterfaceFile(void const *data, std::size_t size) : data_(data), size_(size) {}
+
+    InterfaceFile::InterfaceFile(InterfaceFile &&other) noexcept
+        : data_(std::exchange(other.data_, nullptr))
+        , size_(std::exchange(other.size_, 0))
+    {}
+
+    InterfaceFile &InterfaceFile::operator=(InterfaceFile &&other) noexcept
+    {
+        std::swap(data_, other.data_);
+        std::swap(size_, other.size_);
+        return *this;
+    }
+
+    InterfaceFile::~InterfaceFile()
+    {
+        if (data_) {
+            ::munmap(const_cast<void *>(data_), size_);
+        }
+    }
+
+    std::span<Format::DeclRecord const> InterfaceFile::Decls() const
+    {
+        return Section_<Format::DeclRecord>(Header_().decls);
+    }
+
+    std::span<Format::SourceRecord const> InterfaceFile::Sources() const
+    {
+        return Section_<Format::SourceRecord>(Header_().sources);
+    }
+
+    std::span<Format::DependencyRecord const> InterfaceFile::Dependencies() const
+    {
+        return Section_<Format::DependencyRecord>(Header_().dependencies);
+    }
+
+    std::span<Format::ParamRecord const> InterfaceFile::Params(Format::DeclRecord const &decl) const
+    {
+        return Section_<Format::ParamRecord>(Header_().params).subspan(decl.first_param, decl.param_count);
+    }
+
+    PackageInterface InterfaceFile::Load() const
+    {
+        PackageInterface interface;
+        interface.package = Package();
+        for (auto const &record: Decls()) {
+            Signature decl;
+            decl.kind = static_cast<DeclKind>(record.kind);
+            decl.name = String_(record.name);
+            decl.abi = String_(record.abi);
+            decl.mangled = String_(record.mangled);
+            decl.ret = static_cast<Lexer::TokenKind>(record.ret);
+            for (auto const &param: Params(record)) {
+                decl.params.push_back({static_cast<Lexer::TokenKind>(param.type), param.is_mut != 0});
+            }
+            interface.decls.push_back(std::move(decl));
+        }
+        for (auto const &record: Sources()) {
+            auto mtime = std::filesystem::file_time_type(std::filesystem::file_time_type::duration(record.mtime));
+            interface.sources.push_back({std::string(String_(record.name)), {mtime, record.size}, record.hash});
+        }
+        for (auto const &record: Dependencies()) {
+            interface.dependencies.push_back({std::string(String_(record.package)), record.interface_hash});
+        }
+        return interface;
+    }
+
+    std::string_view InterfaceFile::String_(Format::StringRef ref) const
+    {
+        auto const *strings = static_cast<char const *>(data_) + Header_().strings.offset;
+        return {strings + ref.offset, ref.size};
+    }
+
+    template<typename T>
+    std::span<T const> InterfaceFile::Section_(Format::Section section) const
+    {
+        auto const *begin = static_cast<char const *>(data_) + section.offset;
+        return {reinterpret_cast<T const *>(begin), section.count};
+    }
+
+    bool InterfaceFile::Validate_(std::string &error) const
+    {
+        auto const &header = Header_();
+        if (std::memcmp(header.magic, Format::kMagic, sizeof(header.magic)) != 0) {
+            error = "not an interface file";
+            return false;
+        }
+        if (header.version != Format::kInterfaceVersion) {
+            error = "interface version " + std::to_string(header.version) + ", expected " +
+                    std::to_string(Format::kInterfaceVersion);
+            return false;
+        }
+
+        auto fits = [this](Format::Section section, std::size_t record_size) {
+            return section.offset % alignof(std::uint64_t) == 0 && section.offset <= size_ &&
+                   section.count <= (size_ - section.offset) / record_size;
+        };
+        if (!fits(header.decls, sizeof(Format::DeclRecord)) || !fits(header.params, sizeof(Format::ParamRecord)) ||
+            !fits(header.sources, sizeof(Format::SourceRecord)) ||
+            !fits(header.dependencies, sizeof(Format::DependencyRecord)) || !fits(header.strings, 1)) {
+            error = "section out of bounds";
+            return false;
+        }
+
+        auto valid_string = [&header](Format::StringRef ref) {
+            return ref.offset <= header.strings.count && ref.size <= header.strings.count - ref.offset;
+        };
+        bool ok = valid_string(header.package);
+        for (auto const &decl: Decls()) {
+            ok = ok && valid_string(decl.name) && valid_string(decl.abi) && valid_string(decl.mangled) &&
+                 decl.first_param <= header.params.count && decl.param_count <= header.params.count - decl.first_param;
+        }
+        for (auto const &source: Sources()) {
+            ok = ok && valid_string(source.name);
+        }
+        for (auto const &dependency: Dependencies()) {
+            ok = ok && valid_string(dependency.package);
+        }
+        if (!ok) {
+            error = "record out of bounds";
+            return false;
+        }
+
+        // Load() casts these bytes straight to enums
+        auto valid_type = [](std::uint8_t type) { return IsTypeKeyword(static_cast<Lexer::TokenKind>(type)); };
+        for (auto const &decl: Decls()) {
+            ok = ok && decl.kind <= static_cast<std::uint8_t>(DeclKind::Extern) && valid_type(decl.ret);
+        }
+        for (auto const &param: Section_<Format::ParamRecord>(header.params)) {
+            ok = ok && valid_type(param.type);
+        }
+        if (!ok) {
+            error = "invalid record";
+        }
+        return ok;
+    }
+
+    InterfaceFile const *InterfaceCache::Open(std::filesystem::path const &path, std::string &error)
+    {
+        auto key = path.string();
+        auto it = files_.find(key);
+        auto stamp = StatFile(path);
+        if (stamp && it != files_.end() && it->second.stamp == *stamp) {
+            hits_++;
+            return &it->second.file;
+        }
+
+        auto file = stamp ? InterfaceFile::Open(path, error) : std::nullopt;
+        if (!file) {
+            if (!stamp) {
+                error = path.string() + ": no such file";
+            }
+            if (it != files_.end()) {
+                files_.erase(it);
+            }
+            return nullptr;
+        }
+        if (it != files_.end()) {
+            it->second = {*stamp, std::move(*file)};
+        }
+        else {
+            it = files_.emplace(std::move(key), Entry{*stamp, std::move(*file)}).first;
+        }
+        return &it->second.file;
+    }
+
+    std::filesystem::path InterfacePath(std::filesystem::path const &package_dir)
+    {
+        return package_dir / ".waffle" / "interface.wfli";
+    }
+
+} // namespace Driver
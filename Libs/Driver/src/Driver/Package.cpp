@@ -0,0 +1,320 @@
+#include <Driver/InterfaceFile.h>
+#include <Driver/Package.h>
+
+#include <algorithm>
+#include <optional>
+#include <unordered_map>
+
+namespace Driver
+{
+
+    namespace Detail
+    {
+        constexpr std::string_view kSourceExtension = ".wfl";
+
+        std::vector<std::filesystem::path> ListSources(std::filesystem::path const &dir)
+        {
+            std::vector<std::filesystem::path> sources;
+            std::error_code ec;
+            for (auto const &entry: std::filesystem::directory_iterator(dir, ec)) {
+                if (entry.is_regular_file() && entry.path().extension() == kSourceExtension) {
+                    sources.push_back(entry.path());
+                }
+            }
+            std::ranges::sort(sources);
+            return sources;
+        }
+
+        class GraphLoader
+        {
+        public:
+            GraphLoader(SourceCache &cache,
+                        InterfaceCache &interfaces,
+                        std::vector<std::filesystem::path> roots,
+                        bool use_interfaces)
+                : cache_(cache)
+                , interfaces_(interfaces)
+                , roots_(std::move(roots))
+                , use_interfaces_(use_interfaces)
+            {}
+
+            // `has_interface` is false when `files` are not the whole directory, as the interface file describes that
+            void Visit(std::string const &id,
+                       std::filesystem::path const &dir,
+                       std::vector<std::filesystem::path> const &files,
+                       bool has_interface = true)
+            {
+                bool const use_interface = use_interfaces_ && has_interface;
+                state_[id] = State::Visiting;
+                stack_.push_back(id);
+                auto const diagnostics_before = graph_.diagnostics.size();
+
+                Package package{id, dir, {}, {}, {}, 0, false};
+                auto const *stored = use_interface ? OpenStored_(id, dir, files) : nullptr;
+                if (stored) {
+                    for (auto const &dependency: stored->Dependencies()) {
+                        package.uses.push_back({std::string(stored->String(dependency.package)),
+                                                InterfacePath(dir).string(), 0});
+                    }
+                    // Replayed uses have no source location, so any use that would be diagnosed is taken from
+                    // the sources instead
+                    if (!std::ranges::all_of(package.uses, [this](UseDecl const &use) { return Replayable_(use); })) {
+                        stored = nullptr;
+                        package.uses.clear();
+                    }
+                }
+                if (!stored) {
+                    Lex_(package, files);
+                }
+
+                for (auto const &use: package.uses) {
+                    auto it = state_.find(use.package);
+                    if (it != state_.end() && it->second == State::Done) {
+                        continue;
+                    }
+                    if (it != state_.end()) {
+                        graph_.diagnostics.push_back({use.file, use.offset, CycleMessage_(use.package)});
+                        continue;
+                    }
+
+                    auto dep_dir = Resolve_(use.package);
+                    if (!dep_dir) {
+                        graph_.diagnostics.push_back({use.file, use.offset, "unknown package '" + use.package + "'"});
+                        continue;
+                    }
+                    Visit(use.package, *dep_dir, ListSources(*dep_dir));
+                }
+
+                if (stored && !DependenciesMatch_(*stored)) {
+                    stored = nullptr;
+                    package.uses.clear();
+                    Lex_(package, files);
+                }
+
+                if (stored) {
+                    package.interface = stored->Load();
+                    package.interface_hash = stored->Hash();
+                    // The sources were just checked against the interface; keep their cache entries warm
+                    for (auto const &path: files) {
+                        cache_.MarkUsed(path);
+                    }
+                }
+                else {
+                    BuildInterface_(package, diagnostics_before, use_interface);
+                }
+
+                stack_.pop_back();
+                state_[id] = State::Done;
+                interface_hashes_[id] = package.interface_hash;
+                graph_.packages.push_back(std::move(package));
+            }
+
+            PackageGraph Take() { return std::move(graph_); }
+
+        private:
+            enum class State
+            {
+                Visiting,
+                Done
+            };
+
+            SourceCache &cache_;
+            InterfaceCache &interfaces_;
+            std::vector<std::filesystem::path> roots_;
+            bool use_interfaces_;
+            std::unordered_map<std::string, State> state_;
+            std::unordered_map<std::string, std::uint64_t> interface_hashes_;
+            std::vector<std::string> stack_;
+            PackageGraph graph_;
+
+            void Lex_(Package &package, std::vector<std::filesystem::path> const &files)
+            {
+                package.checked = true;
+                for (auto const &path: files) {
+                    auto const *file = cache_.Get(path);
+                    if (!file) {
+                        graph_.diagnostics.push_back({path.string(), 0, "cannot read file"});
+                        continue;
+                    }
+                    package.files.push_back(file);
+                    auto uses = CollectUses(*file);
+                    package.uses.insert(package.uses.end(), uses.begin(), uses.end());
+                }
+            }
+
+            // Returns the stored interface of a package if it was produced from exactly the current sources.
+            [[nodiscard]] InterfaceFile const *OpenStored_(std::string const &id,
+                                                           std::filesystem::path const &dir,
+                                                           std::vector<std::filesystem::path> const &files)
+            {
+                std::string error;
+                auto const *stored = interfaces_.Open(InterfacePath(dir), error);
+                if (!stored || stored->Package() != id || stored->Sources().size() != files.size()) {
+                    return nullptr;
+                }
+
+                for (std::size_t i = 0; i < files.size(); ++i) {
+                    auto const &record = stored->Sources()[i];
+                    if (stored->String(record.name) != files[i].filename().string()) {
+                        return nullptr;
+                    }
+
+                    std::error_code ec;
+                    auto size = std::filesystem::file_size(files[i], ec);
+                    auto mtime = std::filesystem::last_write_time(files[i], ec);
+                    if (ec || size != record.size) {
+                        return nullptr;
+                    }
+                    // A touched file still matches if its contents are the same
+                    if (mtime.time_since_epoch().count() != record.mtime && HashFile(files[i]) != record.hash) {
+                        return nullptr;
+                    }
+                }
+                return stored;
+            }
+
+            [[nodiscard]] bool Replayable_(UseDecl const &use) const
+            {
+                auto it = state_.find(use.package);
+                return it != state_.end() ? it->second == State::Done : Resolve_(use.package).has_value();
+            }
+
+            [[nodiscard]] bool DependenciesMatch_(InterfaceFile const &stored) const
+            {
+                return std::ranges::all_of(stored.Dependencies(), [&](auto const &dependency) {
+                    auto it = interface_hashes_.find(std::string(stored.String(dependency.package)));
+                    return it != interface_hashes_.end() && it->second == dependency.interface_hash;
+                });
+            }
+
+            void BuildInterface_(Package &package, std::size_t diagnostics_before, bool write)
+            {
+                auto &interface = package.interface;
+                interface.package = package.id;
+                for (auto const *file: package.files) {
+                    ExtractSignatures(*file, package.id, interface.decls, graph_.diagnostics);
+                    interface.sources.push_back({file->path.filename().string(), file->stamp, file->hash});
+                }
+                std::ranges::sort(interface.decls, {}, &Signature::mangled);
+
+                for (auto const &use: package.uses) {
+                    if (std::ranges::find(interface.dependencies, use.package, &DependencyRecord::package) ==
+                        interface.dependencies.end()) {
+                        interface.dependencies.push_back({use.package, interface_hashes_[use.package]});
+                    }
+                }
+                package.interface_hash = interface.Hash();
+
+                if (!write) {
+                    return;
+                }
+
+                // Only a package that checked cleanly may be skipped next time
+                bool const clean = graph_.diagnostics.size() == diagnostics_before &&
+                                   std::ranges::none_of(package.files, [](SourceFile const *file) {
+                                       return file->utf8_error ||
+                                              std::ranges::any_of(file->tokens, [](auto const &token) {
+                                                  return token.kind == Lexer::TokenKind::Error;
+                                              });
+                                   });
+                std::string error;
+                if (!clean || !WriteInterface(InterfacePath(package.dir), interface, error)) {
+                    // A stale file must not outlive a failed check; unwritable directories just go without
+                    std::error_code ec;
+                    std::filesystem::remove(InterfacePath(package.dir), ec);
+                }
+            }
+
+            [[nodiscard]] std::optional<std::filesystem::path> Resolve_(std::string const &package) const
+            {
+                std::filesystem::path relative;
+                std::size_t begin = 0;
+                while (begin <= package.size()) {
+                    auto end = std::min(package.find('.', begin), package.size());
+                    relative /= package.substr(begin, end - begin);
+                    begin = end + 1;
+                }
+
+                for (auto const &root: roots_) {
+                    std::error_code ec;
+                    if (std::filesystem::is_directory(root / relative, ec)) {
+                        return root / relative;
+                    }
+                }
+                return std::nullopt;
+            }
+
+            [[nodiscard]] std::string CycleMessage_(std::string const &package) const
+            {
+                std::string message = "package cycle: ";
+                auto it = std::ranges::find(stack_, package);
+                for (; it != stack_.end(); ++it) {
+                    message += *it + " -> ";
+                }
+                return message + package;
+            }
+        };
+    } // namespace Detail
+
+    std::vector<UseDecl> CollectUses(SourceFile const &file)
+    {
+        std::vector<UseDecl> uses;
+        auto const &tokens = file.tokens;
+        std::size_t depth = 0;
+
+        for (std::size_t i = 0; i < tokens.size(); ++i) {
+            switch (tokens[i].kind) {
+                case Lexer::TokenKind::LBrace: depth++; break;
+                case Lexer::TokenKind::RBrace: depth -= depth > 0 ? 1 : 0; break;
+                case Lexer::TokenKind::Use: {
+                    if (depth != 0 || i + 1 >= tokens.size() || tokens[i + 1].kind != Lexer::TokenKind::Ident) {
+                        break;
+                    }
+                    UseDecl use{std::string(tokens[i + 1].lexeme), file.path.string(), tokens[i].span.start};
+                    i += 1;
+                    while (i + 2 < tokens.size() && tokens[i + 1].kind == Lexer::TokenKind::Dot &&
+                           tokens[i + 2].kind == Lexer::TokenKind::Ident) {
+                        use.package += ".";
+                        use.package += tokens[i + 2].lexeme;
+                        i += 2;
+                    }
+                    uses.push_back(std::move(use));
+                    break;
+                }
+                default: break;
+            }
+        }
+        return uses;
+    }
+
+    PackageGraph LoadPackageGraph(SourceCache &cache, std::filesystem::path const &root, LoadOptions const &options)
+    {
+        auto const absolute_root = std::filesystem::absolute(root).lexically_normal();
+        bool const is_file = std::filesystem::is_regular_file(absolute_root);
+        auto dir = is_file ? absolute_root.parent_path() : absolute_root;
+        if (!is_file && !dir.has_filename()) {
+            dir = dir.parent_path(); // trailing separator
+        }
+
+        std::error_code ec;
+        if (!std::filesystem::is_directory(dir, ec)) {
+            return {{}, {{root.string(), 0, "no such package directory"}}};
+        }
+        auto files = is_file ? std::vector{absolute_root} : Detail::ListSources(dir);
+        if (files.empty()) {
+            return {{}, {{root.string(), 0, "no source files in package"}}};
+        }
+
+        std::vector<std::filesystem::path> roots{dir.parent_path()};
+        roots.insert(roots.end(), options.search_paths.begin(), options.search_paths.end());
+
+        InterfaceCache local_interfaces;
+        Detail::GraphLoader loader(cache, options.interfaces ? *options.interfaces : local_interfaces, std::move(roots),
+                                   options.use_interfaces);
+        auto id = dir.filename().string();
+        // A single file is checked as its own package and must not replace the interface of its directory
+        loader.Visit(id, dir, files, !is_file);
+        return loader.Take();
+    }
+
+} // namespace Driver
@@ -0,0 +1,300 @@
+#include <Driver/Server.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace Driver
+{
+
+    namespace Detail
+    {
+        constexpr std::string_view kRequestEnd = "\n\n";
+
+        bool MakeAddress(std::filesystem::path const &path, sockaddr_un &address, std::string &error)
+        {
+            auto const native = path.string();
+            address = {};
+            address.sun_family = AF_UNIX;
+            if (native.size() >= sizeof(address.sun_path)) {
+                error = "socket path too long: " + native;
+                return false;
+            }
+            std::memcpy(address.sun_path, native.c_str(), native.size() + 1);
+            return true;
+        }
+
+        bool WriteAll(int fd, std::string_view data)
+        {
+            while (!data.empty()) {
+                auto written = ::send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+                if (written < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    return false;
+                }
+                data.remove_prefix(static_cast<std::size_t>(written));
+            }
+            return true;
+        }
+
+        // Reads until `terminator` has been received or the peer closes the connection.
+        std::string ReadUntil(int fd, std::string_view terminator)
+        {
+            std::string data;
+            char chunk[4096];
+            while (terminator.empty() || !data.ends_with(terminator)) {
+                auto received = ::recv(fd, chunk, sizeof(chunk), 0);
+                if (received < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (received <= 0) {
+                    break;
+                }
+                data.append(chunk, static_cast<std::size_t>(received));
+            }
+            return data;
+        }
+
+        // Reads a whole request, or returns std::nullopt if the client closes the connection or has not sent the
+        // terminating empty line within `timeout`, so a stalled client cannot hold up the server.
+        std::optional<std::string> ReadRequest(int fd, std::chrono::milliseconds timeout)
+        {
+            auto const deadline = std::chrono::steady_clock::now() + timeout;
+            std::string data;
+            char chunk[4096];
+            while (!data.ends_with(kRequestEnd)) {
+                auto const remaining = std::chrono::ceil<std::chrono::milliseconds>(deadline -
+                                                                                     std::chrono::steady_clock::now());
+                if (remaining.count() <= 0) {
+                    return std::nullopt;
+                }
+                pollfd readable{fd, POLLIN, 0};
+                int ready = ::poll(&readable, 1, static_cast<int>(remaining.count()));
+                if (ready < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (ready <= 0) {
+                    return std::nullopt;
+                }
+
+                auto received = ::recv(fd, chunk, sizeof(chunk), 0);
+                if (received < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (received <= 0) {
+                    return std::nullopt;
+                }
+                data.append(chunk, static_cast<std::size_t>(received));
+            }
+            return data;
+        }
+
+        std::string ErrnoMessage(std::string_view what) { return std::string(what) + ": " + std::strerror(errno); }
+
+        // Removes a socket file left behind by a server that is gone, which would make bind fail. A socket that a
+        // server still answers on, or anything that is not a socket, is left alone and reported in `error`.
+        bool RemoveStaleSocket(std::filesystem::path const &path, sockaddr_un const &address, std::string &error)
+        {
+            std::error_code ec;
+            auto const status = std::filesystem::symlink_status(path, ec);
+            if (!std::filesystem::exists(status)) {
+                return true;
+            }
+            if (!std::filesystem::is_socket(status)) {
+                error = path.string() + " exists and is not a socket";
+                return false;
+            }
+
+            int probe = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            if (probe < 0) {
+                error = ErrnoMessage("socket");
+                return false;
+            }
+            bool const answered = ::connect(probe, reinterpret_cast<sockaddr const *>(&address), sizeof(address)) == 0;
+            int const connect_errno = errno;
+            ::close(probe);
+            if (answered) {
+                error = "a server is already listening on " + path.string();
+                return false;
+            }
+            if (connect_errno != ECONNREFUSED) {
+                error = "connect " + path.string() + ": " + std::strerror(connect_errno);
+                return false;
+            }
+
+            std::filesystem::remove(path, ec);
+            return true;
+        }
+    } // namespace Detail
+
+    std::string EncodeRequest(std::string_view command, std::vector<std::string> const &args)
+    {
+        std::string request(command);
+        request += "\n";
+        for (auto const &arg: args) {
+            request += arg + "\n";
+        }
+        request += "\n";
+        return request;
+    }
+
+    std::filesystem::path DefaultSocketPath()
+    {
+        if (char const *runtime_dir = std::getenv("XDG_RUNTIME_DIR"); runtime_dir && *runtime_dir) {
+            return std::filesystem::path(runtime_dir) / "waffle.sock";
+        }
+        return std::filesystem::temp_directory_path() / ("waffle-" + std::to_string(::getuid()) + ".sock");
+    }
+
+    Server::Server(std::filesystem::path socket_path, std::vector<std::filesystem::path> search_paths)
+        : socket_path_(std::move(socket_path))
+        , compiler_(std::move(search_paths))
+    {}
+
+    Server::~Server()
+    {
+        if (fd_ >= 0) {
+            ::close(fd_);
+            std::error_code ec;
+            std::filesystem::remove(socket_path_, ec);
+        }
+    }
+
+    bool Server::Listen(std::string &error)
+    {
+        sockaddr_un address{};
+        if (!Detail::MakeAddress(socket_path_, address, error) ||
+            !Detail::RemoveStaleSocket(socket_path_, address, error)) {
+            return false;
+        }
+
+        fd_ = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd_ < 0) {
+            error = Detail::ErrnoMessage("socket");
+            return false;
+        }
+
+        if (::bind(fd_, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0 || ::listen(fd_, 16) < 0) {
+            error = Detail::ErrnoMessage("bind " + socket_path_.string());
+            ::close(fd_);
+            fd_ = -1;
+            return false;
+        }
+
+        running_ = true;
+        return true;
+    }
+
+    void Server::Serve()
+    {
+        while (running_) {
+            int client = ::accept(fd_, nullptr, nullptr);
+            if (client < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                break;
+            }
+
+            // A client that stops reading the response is dropped as well
+            auto const seconds = std::chrono::duration_cast<std::chrono::seconds>(request_timeout_);
+            timeval send_timeout{static_cast<time_t>(seconds.count()),
+                                 static_cast<suseconds_t>((request_timeout_ - seconds).count() * 1000)};
+            ::setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &send_timeout, sizeof(send_timeout));
+
+            if (auto request = Detail::ReadRequest(client, request_timeout_)) {
+                Detail::WriteAll(client, Handle(*request));
+            }
+            ::close(client);
+        }
+    }
+
+    std::string Server::Handle(std::string_view request)
+    {
+        std::vector<std::string> lines;
+        std::istringstream input{std::string(request)};
+        for (std::string line; std::getline(input, line) && !line.empty();) {
+            lines.push_back(std::move(line));
+        }
+
+        if (lines.empty()) {
+            return "status error empty request\n";
+        }
+
+        auto const &command = lines.front();
+        if (command == "shutdown") {
+            running_ = false;
+            return "status ok\n";
+        }
+        if (command == "stats") {
+            return "status ok files=" + std::to_string(compiler_.Cache().Size()) +
+                   " symbols=" + std::to_string(compiler_.Cache().Symbols().Size()) + "\n";
+        }
+        if (command != "check" && command != "build") {
+            return "status error unknown command '" + command + "'\n";
+        }
+
+        RunOptions options;
+        options.command = command == "build" ? Command::Build : Command::Check;
+        std::vector<std::filesystem::path> roots;
+        for (std::size_t i = 1; i < lines.size(); ++i) {
+            if (lines[i] == "--alloc-stats") {
+                options.alloc_stats = true;
+            }
+            else if (lines[i] == "--no-interfaces") {
+                options.use_interfaces = false;
+            }
+            else {
+                roots.emplace_back(lines[i]);
+            }
+        }
+        if (roots.size() != 1) {
+            return "status error expected exactly one package path\n";
+        }
+
+        return FormatResult(compiler_.Run(roots.front(), options));
+    }
+
+    std::optional<std::string> SendRequest(std::filesystem::path const &socket_path,
+                                           std::string_view request,
+                                           std::string &error)
+    {
+        sockaddr_un address{};
+        if (!Detail::MakeAddress(socket_path, address, error)) {
+            return std::nullopt;
+        }
+
+        int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) {
+            error = Detail::ErrnoMessage("socket");
+            return std::nullopt;
+        }
+
+        if (::connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0) {
+            error = Detail::ErrnoMessage("connect " + socket_path.string());
+            ::close(fd);
+            return std::nullopt;
+        }
+
+        if (!Detail::WriteAll(fd, request)) {
+            error = Detail::ErrnoMessage("send");
+            ::close(fd);
+            return std::nullopt;
+        }
+        ::shutdown(fd, SHUT_WR);
+
+        auto response = Detail::ReadUntil(fd, {});
+        ::close(fd);
+        return response;
+    }
+
+} // namespace Driver
@@ -0,0 +1,185 @@
+#include <Driver/SourceCache.h>
+#include <Lexer/Lexer.h>
+
+#include <fstream>
+#include <spanstream>
+
+namespace Driver
+{
+
+    std::optional<FileStamp> StatFile(std::filesystem::path const &path)
+    {
+        std::error_code ec;
+        auto size = std::filesystem::file_size(path, ec);
+        if (ec) {
+            return std::nullopt;
+        }
+        auto mtime = std::filesystem::last_write_time(path, ec);
+        if (ec) {
+            return std::nullopt;
+        }
+        return FileStamp{mtime, size};
+    }
+
+    std::uint64_t HashContents(std::string_view contents, std::uint64_t seed)
+    {
+        std::uint64_t hash = seed;
+        for (unsigned char c: contents) {
+            hash ^= c;
+            hash *= 0x100000001b3ull;
+        }
+        return hash;
+    }
+
+    std::optional<std::uint64_t> HashFile(std::filesystem::path const &path)
+    {
+        std::ifstream input(path, std::ios::binary);
+        if (!input) {
+            return std::nullopt;
+        }
+
+        auto hash = kHashSeed;
+        char chunk[1 << 14];
+        while (input.read(chunk, sizeof(chunk)) || input.gcount() > 0) {
+            hash = HashContents(std::string_view(chunk, static_cast<std::size_t>(input.gcount())), hash);
+        }
+        return hash;
+    }
+
+    SourceFile::SourceFile(std::filesystem::path path, FileStamp stamp, std::size_t size)
+        : path(std::move(path))
+        , stamp(stamp)
+        , arena(std::make_unique<Memory::FileArena>(size))
+        , lex_phase(arena->Resource())
+        , contents(arena->Resource())
+        , tokens(&lex_phase)
+        , symbols(&lex_phase)
+    {}
+
+    SourceFile const *SourceCache::Get(std::filesystem::path const &path)
+    {
+        auto stamp = StatFile(path);
+        auto key = path.string();
+        auto it = files_.find(key);
+        if (!stamp) {
+            if (it != files_.end()) {
+                Release_(*it->second);
+                files_.erase(it);
+            }
+            return nullptr;
+        }
+
+        if (it != files_.end() && it->second->stamp == *stamp) {
+            stats_.hits++;
+            it->second->last_run = run_;
+            return it->second.get();
+        }
+
+        auto file = Load_(path, *stamp);
+        if (!file) {
+            return nullptr;
+        }
+
+        if (it != files_.end()) {
+            if (it->second->hash == file->hash) {
+                // Touched but unchanged: keep the lexed entry and drop the freshly read copy
+                stats_.stamp_refreshes++;
+                it->second->stamp = *stamp;
+                it->second->last_run = run_;
+                return it->second.get();
+            }
+            Release_(*it->second);
+            it->second = std::move(file);
+        }
+        else {
+            it = files_.emplace(std::move(key), std::move(file)).first;
+        }
+
+        SourceFile &entry = *it->second;
+        entry.last_run = run_;
+        stats_.lexed++;
+        // Validating the whole buffer up front also covers comments, which the lexer skips without decoding
+        entry.utf8_error = Lexer::ValidateUtf8(entry.contents);
+        if (entry.utf8_error) {
+            return &entry;
+        }
+
+        std::ispanstream input(std::span<char const>(entry.contents.data(), entry.contents.size()));
+        Lexer::Lexer lexer(input, entry.path.string(), &entry.lex_phase);
+        entry.tokens = lexer.Tokenize();
+        entry.symbols.reserve(entry.tokens.size());
+        for (auto const &token: entry.tokens) {
+            entry.symbols.push_back(token.kind == Lexer::TokenKind::Ident ? symbols_.Intern(token.lexeme) : kNoSymbol);
+        }
+        return &entry;
+    }
+
+    void SourceCache::MarkUsed(std::filesystem::path const &path)
+    {
+        auto it = files_.find(path.string());
+        if (it == files_.end()) {
+            return;
+        }
+        if (auto stamp = StatFile(path); stamp && it->second->stamp == *stamp) {
+            stats_.hits++;
+            it->second->last_run = run_;
+        }
+    }
+
+    void SourceCache::Invalidate(std::filesystem::path const &path)
+    {
+        if (auto it = files_.find(path.string()); it != files_.end()) {
+            Release_(*it->second);
+            files_.erase(it);
+        }
+    }
+
+    void SourceCache::Clear()
+    {
+        files_.clear();
+        symbols_.Clear();
+    }
+
+    void SourceCache::EvictUnused()
+    {
+        for (auto it = files_.begin(); it != files_.end();) {
+            auto const &entry = *it->second;
+            // An entry Get() returned in this run has just been checked against the file
+            bool const evict = entry.last_run != run_ &&
+                               (run_ - entry.last_run >= kMaxIdleRuns || !StatFile(entry.path));
+            if (evict) {
+                Release_(entry);
+                it = files_.erase(it);
+                stats_.evicted++;
+            }
+            else {
+                ++it;
+            }
+        }
+    }
+
+    std::unique_ptr<SourceFile> SourceCache::Load_(std::filesystem::path const &path, FileStamp stamp)
+    {
+        std::ifstream input(path, std::ios::binary);
+        if (!input) {
+            return nullptr;
+        }
+
+        auto file = std::make_unique<SourceFile>(path, stamp, stamp.size);
+        file->contents.resize(stamp.size);
+        input.read(file->contents.data(), static_cast<std::streamsize>(file->contents.size()));
+        file->contents.resize(static_cast<std::size_t>(input.gcount()));
+        file->hash = HashContents(file->contents);
+        return file;
+    }
+
+    void SourceCache::Release_(SourceFile const &file)
+    {
+        for (auto symbol: file.symbols) {
+            if (symbol != kNoSymbol) {
+                symbols_.Release(symbol);
+            }
+        }
+    }
+
+} // namespace Driver
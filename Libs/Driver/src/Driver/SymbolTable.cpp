@@ -0,0 +1,62 @@
+#include <Driver/SymbolTable.h>
+
+#include <cstring>
+
+namespace Driver
+{
+
+    SymbolId SymbolTable::Intern(std::string_view name)
+    {
+        if (auto it = ids_.find(name); it != ids_.end()) {
+            references_[it->second]++;
+            return it->second;
+        }
+
+        auto *data = static_cast<char *>(storage_.allocate(name.size(), 1));
+        std::memcpy(data, name.data(), name.size());
+        std::string_view stored(data, name.size());
+
+        SymbolId id;
+        if (free_.empty()) {
+            id = static_cast<SymbolId>(names_.size());
+            names_.push_back(stored);
+            references_.push_back(1);
+        }
+        else {
+            id = free_.back();
+            free_.pop_back();
+            names_[id] = stored;
+            references_[id] = 1;
+        }
+        ids_.emplace(stored, id);
+        return id;
+    }
+
+    void SymbolTable::Release(SymbolId id)
+    {
+        if (--references_[id] > 0) {
+            return;
+        }
+        auto const name = names_[id];
+        ids_.erase(name);
+        storage_.deallocate(const_cast<char *>(name.data()), name.size(), 1);
+        names_[id] = {};
+        free_.push_back(id);
+    }
+
+    SymbolId SymbolTable::Find(std::string_view name) const
+    {
+        auto it = ids_.find(name);
+        return it != ids_.end() ? it->second : kNoSymbol;
+    }
+
+    void SymbolTable::Clear()
+    {
+        ids_.clear();
+        names_.clear();
+        references_.clear();
+        free_.clear();
+        storage_.release();
+    }
+
+} // namespace Driver
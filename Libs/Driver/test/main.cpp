@@ -0,0 +1,673 @@
+#include <Driver/Compiler.h>
+#include <Driver/InterfaceFile.h>
+#include <Driver/Package.h>
+#include <Driver/Server.h>
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <thread>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace
+{
+
+    // Creates a fresh workspace directory per test and removes it afterwards
+    class Workspace : public ::testing::Test
+    {
+    protected:
+        std::filesystem::path root_;
+
+        void SetUp() override
+        {
+            auto const *info = ::testing::UnitTest::GetInstance()->current_test_info();
+            root_ = std::filesystem::temp_directory_path() /
+                    (std::string("waffle-driver-") + info->test_suite_name() + "-" + info->name());
+            std::filesystem::remove_all(root_);
+            std::filesystem::create_directories(root_);
+        }
+
+        void TearDown() override { std::filesystem::remove_all(root_); }
+
+        std::filesystem::path Write(std::filesystem::path const &relative, std::string_view contents) const
+        {
+            auto path = root_ / relative;
+            std::filesystem::create_directories(path.parent_path());
+            std::ofstream(path, std::ios::binary | std::ios::trunc) << contents;
+            return path;
+        }
+    };
+
+    void Touch(std::filesystem::path const &path)
+    {
+        std::filesystem::last_write_time(path, std::filesystem::last_write_time(path) + std::chrono::seconds(1));
+    }
+
+} // namespace
+
+//
+// SymbolTable
+//
+TEST(DriverSymbolTable, InternIsStable)
+{
+    Driver::SymbolTable symbols;
+    auto foo = symbols.Intern("foo");
+    auto bar = symbols.Intern("bar");
+
+    EXPECT_NE(foo, bar);
+    EXPECT_EQ(symbols.Intern(std::string("foo")), foo);
+    EXPECT_EQ(symbols.Name(bar), "bar");
+    EXPECT_EQ(symbols.Find("baz"), Driver::kNoSymbol);
+}
+
+TEST(DriverSymbolTable, ReleaseDropsUnreferencedNames)
+{
+    Driver::SymbolTable symbols;
+    auto foo = symbols.Intern("foo");
+    symbols.Intern("foo");
+    symbols.Intern("bar");
+
+    symbols.Release(foo);
+    EXPECT_EQ(symbols.Find("foo"), foo);
+    symbols.Release(foo);
+    EXPECT_EQ(symbols.Find("foo"), Driver::kNoSymbol);
+    EXPECT_EQ(symbols.Size(), 1u);
+
+    // The freed id is reused
+    EXPECT_EQ(symbols.Intern("baz"), foo);
+    EXPECT_EQ(symbols.Name(foo), "baz");
+}
+
+//
+// SourceCache
+//
+using DriverSourceCache = Workspace;
+
+TEST_F(DriverSourceCache, ReusesUnchangedFile)
+{
+    auto path = Write("app/main.wfl", "func main() int32 { return 0; }");
+    Driver::SourceCache cache;
+
+    auto const *first = cache.Get(path);
+    ASSERT_NE(first, nullptr);
+    auto const *second = cache.Get(path);
+
+    EXPECT_EQ(first, second);
+    EXPECT_EQ(cache.Stats().lexed, 1u);
+    EXPECT_EQ(cache.Stats().hits, 1u);
+    EXPECT_EQ(first->symbols[1], cache.Symbols().Find("main"));
+}
+
+TEST_F(DriverSourceCache, TouchedFileKeepsTokens)
+{
+    auto path = Write("app/main.wfl", "func main() int32 { return 0; }");
+    Driver::SourceCache cache;
+    ASSERT_NE(cache.Get(path), nullptr);
+
+    Touch(path);
+    ASSERT_NE(cache.Get(path), nullptr);
+
+    EXPECT_EQ(cache.Stats().lexed, 1u);
+    EXPECT_EQ(cache.Stats().stamp_refreshes, 1u);
+}
+
+TEST_F(DriverSourceCache, ChangedFileIsRelexed)
+{
+    auto path = Write("app/main.wfl", "func main() int32 { return 0; }");
+    Driver::SourceCache cache;
+    ASSERT_NE(cache.Get(path), nullptr);
+
+    Write("app/main.wfl", "func main() int32 { return 42; }");
+    Touch(path);
+    auto const *file = cache.Get(path);
+
+    ASSERT_NE(file, nullptr);
+    EXPECT_EQ(cache.Stats().lexed, 2u);
+    EXPECT_EQ(file->tokens[7].lexeme, "42");
+}
+
+TEST_F(DriverSourceCache, MissingFile)
+{
+    Driver::SourceCache cache;
+    EXPECT_EQ(cache.Get(root_ / "missing.wfl"), nullptr);
+}
+
+TEST_F(DriverSourceCache, EvictsDeletedFiles)
+{
+    auto kept = Write("app/main.wfl", "func main() int32 { return 0; }");
+    auto deleted = Write("app/old.wfl", "func old_helper() void {}");
+    Driver::SourceCache cache;
+    cache.BeginRun();
+    ASSERT_NE(cache.Get(kept), nullptr);
+    ASSERT_NE(cache.Get(deleted), nullptr);
+
+    std::filesystem::remove(deleted);
+    cache.BeginRun();
+    auto const *file = cache.Get(kept);
+    cache.EvictUnused();
+
+    EXPECT_EQ(cache.Size(), 1u);
+    EXPECT_EQ(cache.Stats().evicted, 1u);
+    // The symbol table only holds the names of the remaining file
+    EXPECT_EQ(cache.Symbols().Find("old_helper"), Driver::kNoSymbol);
+    EXPECT_EQ(cache.Symbols().Name(file->symbols[1]), "main");
+}
+
+TEST_F(DriverSourceCache, EditsDoNotGrowSymbols)
+{
+    auto path = Write("app/main.wfl", "func main() int32 { return helper_0; }");
+    Driver::SourceCache cache;
+    ASSERT_NE(cache.Get(path), nullptr);
+    auto const symbols = cache.Symbols().Size();
+
+    for (int edit = 1; edit <= 20; ++edit) {
+        Write("app/main.wfl", "func main() int32 { return helper_" + std::to_string(edit) + "; }");
+        Touch(path);
+        auto const *file = cache.Get(path);
+        ASSERT_NE(file, nullptr);
+        EXPECT_EQ(cache.Symbols().Size(), symbols);
+        EXPECT_EQ(cache.Symbols().Name(file->symbols[7]), "helper_" + std::to_string(edit));
+    }
+    EXPECT_EQ(cache.Symbols().Find("helper_0"), Driver::kNoSymbol);
+
+    cache.Invalidate(path);
+    EXPECT_EQ(cache.Symbols().Size(), 0u);
+}
+
+TEST_F(DriverSourceCache, EvictsIdleFiles)
+{
+    auto first = Write("a/main.wfl", "func a() void {}");
+    auto second = Write("b/main.wfl", "func b() void {}");
+    Driver::SourceCache cache;
+    cache.BeginRun();
+    ASSERT_NE(cache.Get(first), nullptr);
+    cache.EvictUnused();
+
+    for (std::uint64_t run = 1; run < Driver::SourceCache::kMaxIdleRuns; ++run) {
+        cache.BeginRun();
+        ASSERT_NE(cache.Get(second), nullptr);
+        cache.EvictUnused();
+    }
+    EXPECT_EQ(cache.Size(), 2u);
+
+    cache.BeginRun();
+    ASSERT_NE(cache.Get(second), nullptr);
+    cache.EvictUnused();
+    EXPECT_EQ(cache.Size(), 1u);
+    EXPECT_EQ(cache.Symbols().Find("a"), Driver::kNoSymbol);
+}
+
+//
+// Package graph
+//
+using DriverPackageGraph = Workspace;
+
+TEST_F(DriverPackageGraph, TopologicalOrder)
+{
+    Write("lib/io/print.wfl", "use lib.fmt;\npublic func print_i32(int32 x) void {}");
+    Write("lib/fmt/fmt.wfl", "public func format() void {}");
+    Write("app/main.wfl", "use lib.io as io;\nuse lib.fmt;\nfunc main() int32 { return 0; }");
+
+    Driver::SourceCache cache;
+    auto graph = Driver::LoadPackageGraph(cache, root_ / "app", {});
+
+    EXPECT_TRUE(graph.diagnostics.empty());
+    ASSERT_EQ(graph.packages.size(), 3u);
+    EXPECT_EQ(graph.packages[0].id, "lib.fmt");
+    EXPECT_EQ(graph.packages[1].id, "lib.io");
+    EXPECT_EQ(graph.packages[2].id, "app");
+}
+
+TEST_F(DriverPackageGraph, UseInsideBlockIsIgnored)
+{
+    auto path = Write("app/main.wfl", "func main() int32 { use nothing; }");
+    Driver::SourceCache cache;
+
+    EXPECT_TRUE(Driver::CollectUses(*cache.Get(path)).empty());
+}
+
+TEST_F(DriverPackageGraph, Cycle)
+{
+    Write("a/a.wfl", "use b;");
+    Write("b/b.wfl", "use a;");
+
+    Driver::SourceCache cache;
+    auto graph = Driver::LoadPackageGraph(cache, root_ / "a", {});
+
+    ASSERT_EQ(graph.diagnostics.size(), 1u);
+    EXPECT_EQ(graph.diagnostics[0].message, "package cycle: a -> b -> a");
+}
+
+TEST_F(DriverPackageGraph, SearchPath)
+{
+    Write("app/main.wfl", "use ext.lib;");
+    Write("elsewhere/ext/lib/lib.wfl", "public func f() void {}");
+
+    Driver::SourceCache cache;
+    auto missing = Driver::LoadPackageGraph(cache, root_ / "app", {});
+    auto found = Driver::LoadPackageGraph(cache, root_ / "app", Driver::LoadOptions{{root_ / "elsewhere"}});
+
+    ASSERT_EQ(missing.diagnostics.size(), 1u);
+    EXPECT_EQ(missing.diagnostics[0].message, "unknown package 'ext.lib'");
+    EXPECT_TRUE(found.diagnostics.empty());
+}
+
+TEST_F(DriverPackageGraph, MissingOrEmptyRoot)
+{
+    std::filesystem::create_directories(root_ / "empty");
+
+    Driver::Compiler compiler;
+    auto missing = compiler.Run(root_ / "missing/app");
+    auto empty = compiler.Run(root_ / "empty");
+
+    EXPECT_FALSE(missing.ok);
+    EXPECT_EQ(missing.packages, 0u);
+    ASSERT_EQ(missing.diagnostics.size(), 1u);
+    EXPECT_EQ(missing.diagnostics[0].message, "no such package directory");
+    EXPECT_FALSE(std::filesystem::exists(root_ / "missing"));
+
+    EXPECT_FALSE(empty.ok);
+    ASSERT_EQ(empty.diagnostics.size(), 1u);
+    EXPECT_EQ(empty.diagnostics[0].message, "no source files in package");
+    EXPECT_FALSE(std::filesystem::exists(root_ / "empty/.waffle"));
+}
+
+//
+// Interfaces
+//
+using DriverInterface = Workspace;
+
+TEST_F(DriverInterface, ExtractPublicSignatures)
+{
+    auto path = Write("lib/io/print.wfl", "use lib.fmt;\n"
+                                          "public extern \"C\" func printf(int8) int32;\n"
+                                          "extern func helper() void;\n"
+                                          "func hidden() void { if (1) { return; } }\n"
+                                          "public func print_i32(mut int32 x, fp64) void { x += 1; }\n");
+    Driver::SourceCache cache;
+    std::vector<Driver::Signature> decls;
+    std::vector<Driver::Diagnostic> diagnostics;
+    Driver::ExtractSignatures(*cache.Get(path), "lib.io", decls, diagnostics);
+
+    EXPECT_TRUE(diagnostics.empty());
+    ASSERT_EQ(decls.size(), 2u);
+    EXPECT_EQ(decls[0].kind, Driver::DeclKind::Extern);
+    EXPECT_EQ(decls[0].mangled, "printf");
+    EXPECT_EQ(decls[0].abi, "C");
+    EXPECT_EQ(decls[0].ret, Lexer::TokenKind::Int32);
+    EXPECT_EQ(decls[1].kind, Driver::DeclKind::Func);
+    EXPECT_EQ(decls[1].mangled, "lib.io::print_i32");
+    ASSERT_EQ(decls[1].params.size(), 2u);
+    EXPECT_EQ(decls[1].params[0], (Driver::Param{Lexer::TokenKind::Int32, true}));
+    EXPECT_EQ(decls[1].params[1], (Driver::Param{Lexer::TokenKind::Fp64, false}));
+}
+
+TEST_F(DriverInterface, MalformedDeclaration)
+{
+    auto path = Write("app/main.wfl", "public func broken(int32 x int32 { }");
+    Driver::SourceCache cache;
+    std::vector<Driver::Signature> decls;
+    std::vector<Driver::Diagnostic> diagnostics;
+    Driver::ExtractSignatures(*cache.Get(path), "app", decls, diagnostics);
+
+    EXPECT_TRUE(decls.empty());
+    ASSERT_EQ(diagnostics.size(), 1u);
+    EXPECT_EQ(diagnostics[0].message, "expected ')'");
+
+    Write("app/main.wfl", "public func broken(x) int32 { }\npublic func worse() x { }");
+    decls.clear();
+    diagnostics.clear();
+    Driver::ExtractSignatures(*cache.Get(path), "app", decls, diagnostics);
+    ASSERT_EQ(diagnostics.size(), 2u);
+    EXPECT_EQ(diagnostics[0].message, "expected parameter type");
+    EXPECT_EQ(diagnostics[1].message, "expected return type");
+}
+
+TEST_F(DriverInterface, FileRoundTrip)
+{
+    Driver::PackageInterface interface;
+    interface.package = "lib.io";
+    interface.decls.push_back({Driver::DeclKind::Func, "f", "", "lib.io::f", {{Lexer::TokenKind::Bool, true}},
+                               Lexer::TokenKind::Uint64});
+    interface.decls.push_back({Driver::DeclKind::Extern, "puts", "C", "puts", {}, Lexer::TokenKind::Int32});
+    interface.sources.push_back({"print.wfl", {std::filesystem::file_time_type::clock::now(), 42}, 7});
+    interface.dependencies.push_back({"lib.fmt", 99});
+
+    auto path = root_ / "lib.wfli";
+    std::string error;
+    ASSERT_TRUE(Driver::WriteInterface(path, interface, error)) << error;
+    auto file = Driver::InterfaceFile::Open(path, error);
+    ASSERT_TRUE(file) << error;
+
+    EXPECT_EQ(file->Hash(), interface.Hash());
+    EXPECT_EQ(file->Package(), "lib.io");
+    auto loaded = file->Load();
+    EXPECT_EQ(loaded.decls, interface.decls);
+    ASSERT_EQ(loaded.sources.size(), 1u);
+    EXPECT_EQ(loaded.sources[0].stamp, interface.sources[0].stamp);
+    EXPECT_EQ(loaded.dependencies[0].package, "lib.fmt");
+    EXPECT_EQ(loaded.dependencies[0].interface_hash, 99u);
+}
+
+TEST_F(DriverInterface, RejectsForeignFiles)
+{
+    std::string error;
+    auto garbage = Write("garbage.wfli", std::string(128, 'x'));
+    auto truncated = Write("truncated.wfli", "WFLI");
+
+    EXPECT_FALSE(Driver::InterfaceFile::Open(garbage, error));
+    EXPECT_FALSE(Driver::InterfaceFile::Open(truncated, error));
+    EXPECT_FALSE(Driver::InterfaceFile::Open(root_ / "missing.wfli", error));
+}
+
+TEST_F(DriverInterface, WriteDoesNotCreatePackageDirectories)
+{
+    Driver::PackageInterface interface{"lib", {}, {}, {}};
+    std::string error;
+    EXPECT_FALSE(Driver::WriteInterface(Driver::InterfacePath(root_ / "missing/lib"), interface, error));
+    EXPECT_FALSE(std::filesystem::exists(root_ / "missing"));
+
+    std::filesystem::create_directories(root_ / "lib");
+    EXPECT_TRUE(Driver::WriteInterface(Driver::InterfacePath(root_ / "lib"), interface, error)) << error;
+}
+
+TEST_F(DriverInterface, RejectsInvalidEnumValues)
+{
+    Driver::PackageInterface interface;
+    interface.package = "lib";
+    interface.decls.push_back({Driver::DeclKind::Func, "f", "", "lib::f", {{Lexer::TokenKind::Bool, false}},
+                               Lexer::TokenKind::Void});
+    auto path = root_ / "lib.wfli";
+    std::string error;
+    ASSERT_TRUE(Driver::WriteInterface(path, interface, error)) << error;
+
+    std::string bytes;
+    {
+        std::ifstream in(path, std::ios::binary);
+        bytes.assign(std::istreambuf_iterator<char>(in), {});
+    }
+    Driver::Format::Header header;
+    std::memcpy(&header, bytes.data(), sizeof(header));
+
+    // Patches one byte of a valid file and expects Open to reject it
+    auto rejects = [&](std::size_t offset, char value) {
+        auto patched = bytes;
+        patched[offset] = value;
+        auto file = Driver::InterfaceFile::Open(Write("patched.wfli", patched), error);
+        return !file && error.ends_with("invalid record");
+    };
+    auto const decl = header.decls.offset;
+    EXPECT_TRUE(rejects(decl + offsetof(Driver::Format::DeclRecord, kind), 2));
+    EXPECT_TRUE(rejects(decl + offsetof(Driver::Format::DeclRecord, ret), static_cast<char>(Lexer::TokenKind::Ident)));
+    EXPECT_TRUE(rejects(header.params.offset + offsetof(Driver::Format::ParamRecord, type), static_cast<char>(0xFF)));
+}
+
+TEST_F(DriverInterface, HashIgnoresBodies)
+{
+    auto path = Write("lib/a.wfl", "public func f(int32 x) int32 { return x; }\nfunc g() void {}");
+    Driver::SourceCache cache;
+    Driver::PackageInterface before{"lib", {}, {}, {}};
+    Driver::PackageInterface after{"lib", {}, {}, {}};
+    std::vector<Driver::Diagnostic> diagnostics;
+
+    Driver::ExtractSignatures(*cache.Get(path), "lib", before.decls, diagnostics);
+    Write("lib/a.wfl", "public func f(int32 y) int32 { return y + 1; }\nfunc g() int32 { return 0; }");
+    Touch(path);
+    Driver::ExtractSignatures(*cache.Get(path), "lib", after.decls, diagnostics);
+
+    EXPECT_EQ(before.Hash(), after.Hash());
+    after.decls[0].ret = Lexer::TokenKind::Int64;
+    EXPECT_NE(before.Hash(), after.Hash());
+}
+
+//
+// Compiler
+//
+using DriverCompiler = Workspace;
+
+TEST_F(DriverCompiler, WarmRunReusesEverything)
+{
+    Write("lib/io/print.wfl", "public func print_i32(int32 x) void {}");
+    Write("app/main.wfl", "use lib.io;\nfunc main() int32 { return 0; }");
+
+    Driver::Compiler compiler;
+    Driver::RunOptions options;
+    options.use_interfaces = false;
+    auto cold = compiler.Run(root_ / "app", options);
+    auto warm = compiler.Run(root_ / "app", options);
+
+    EXPECT_TRUE(cold.ok);
+    EXPECT_EQ(cold.cache.lexed, 2u);
+    EXPECT_TRUE(warm.ok);
+    EXPECT_EQ(warm.cache.lexed, 0u);
+    EXPECT_EQ(warm.cache.hits, 2u);
+}
+
+TEST_F(DriverCompiler, InterfacesSkipUnchangedPackages)
+{
+    auto lib = Write("lib/io/print.wfl", "public func print_i32(int32 x) void { x; }");
+    Write("app/main.wfl", "use lib.io;\nfunc main() int32 { return 0; }");
+
+    auto run = [this] { return Driver::Compiler().Run(root_ / "app"); };
+    auto cold = run();
+    auto warm = run();
+
+    Write("lib/io/print.wfl", "public func print_i32(int32 x) void { x + 1; }");
+    Touch(lib);
+    auto body_edit = run();
+
+    Write("lib/io/print.wfl", "public func print_i32(int64 x) void { x + 1; }");
+    Touch(lib);
+    auto signature_edit = run();
+
+    EXPECT_TRUE(cold.ok);
+    EXPECT_EQ(cold.checked, 2u);
+    EXPECT_TRUE(std::filesystem::exists(Driver::InterfacePath(root_ / "lib/io")));
+    EXPECT_EQ(warm.checked, 0u);
+    EXPECT_EQ(warm.cache.lexed, 0u);
+    EXPECT_EQ(body_edit.checked, 1u);
+    EXPECT_EQ(signature_edit.checked, 2u);
+}
+
+TEST_F(DriverCompiler, InterfaceRunsKeepCachesWarm)
+{
+    Write("lib/io/print.wfl", "public func print_i32(int32 x) void {}");
+    Write("app/main.wfl", "use lib.io;\nfunc main() int32 { return 0; }");
+
+    Driver::Compiler compiler;
+    ASSERT_TRUE(compiler.Run(root_ / "app").ok);
+    for (std::uint64_t run = 0; run <= Driver::SourceCache::kMaxIdleRuns; ++run) {
+        auto warm = compiler.Run(root_ / "app");
+        ASSERT_TRUE(warm.ok);
+        EXPECT_EQ(warm.checked, 0u);
+        EXPECT_EQ(warm.cache.hits, 2u);
+        EXPECT_EQ(warm.cache.evicted, 0u);
+    }
+    EXPECT_EQ(compiler.Cache().Size(), 2u);
+    // Both interface files were opened by the first warm run and then served from memory
+    EXPECT_EQ(compiler.Interfaces().Size(), 2u);
+    EXPECT_EQ(compiler.Interfaces().Hits(), 2 * Driver::SourceCache::kMaxIdleRuns);
+}
+
+TEST_F(DriverCompiler, SingleFileKeepsDirectoryInterface)
+{
+    Write("app/helper.wfl", "public func helper() void {}");
+    auto main = Write("app/main.wfl", "func main() int32 { return 0; }");
+
+    Driver::Compiler compiler;
+    ASSERT_TRUE(compiler.Run(root_ / "app").ok);
+    auto const directory_stamp = Driver::StatFile(Driver::InterfacePath(root_ / "app"));
+    ASSERT_TRUE(directory_stamp);
+
+    auto single = compiler.Run(main);
+    auto directory = compiler.Run(root_ / "app");
+
+    EXPECT_TRUE(single.ok);
+    EXPECT_EQ(single.checked, 1u);
+    EXPECT_EQ(Driver::StatFile(Driver::InterfacePath(root_ / "app")), directory_stamp);
+    EXPECT_EQ(directory.checked, 0u);
+}
+
+TEST_F(DriverCompiler, FailedPackageIsNotSkipped)
+{
+    Write("app/main.wfl", "func main() int32 { return @; }");
+
+    auto first = Driver::Compiler().Run(root_ / "app");
+    auto second = Driver::Compiler().Run(root_ / "app");
+
+    EXPECT_FALSE(first.ok);
+    EXPECT_FALSE(second.ok);
+    EXPECT_EQ(second.checked, 1u);
+    EXPECT_FALSE(std::filesystem::exists(Driver::InterfacePath(root_ / "app")));
+}
+
+TEST_F(DriverCompiler, RemovedDependencyIsReportedAtTheUse)
+{
+    Write("lib/io/print.wfl", "public func print_i32(int32 x) void {}");
+    auto app = Write("app/main.wfl", "// app\nuse lib.io;\nfunc main() int32 { return 0; }");
+    ASSERT_TRUE(Driver::Compiler().Run(root_ / "app").ok);
+    ASSERT_TRUE(std::filesystem::exists(Driver::InterfacePath(root_ / "app")));
+
+    std::filesystem::remove_all(root_ / "lib");
+    auto result = Driver::Compiler().Run(root_ / "app");
+
+    EXPECT_FALSE(result.ok);
+    ASSERT_EQ(result.diagnostics.size(), 1u);
+    EXPECT_EQ(result.diagnostics[0].file, app.string());
+    EXPECT_EQ(result.diagnostics[0].offset, 7u);
+    EXPECT_EQ(result.diagnostics[0].message, "unknown package 'lib.io'");
+}
+
+TEST_F(DriverCompiler, ReportsErrorTokens)
+{
+    Write("app/main.wfl", "func main() int32 { return @; }");
+
+    Driver::Compiler compiler;
+    auto result = compiler.Run(root_ / "app");
+
+    EXPECT_FALSE(result.ok);
+    ASSERT_EQ(result.diagnostics.size(), 1u);
+    EXPECT_EQ(result.diagnostics[0].offset, 27u);
+    EXPECT_EQ(result.diagnostics[0].message, "unexpected '@'");
+}
+
+TEST_F(DriverCompiler, ReportsInvalidUtf8)
+{
+    // The bad byte sits in a comment, which the lexer alone would skip
+    Write("app/main.wfl", "// größe \xC0\xAF\nfunc main() int32 { return 0; }");
+
+    Driver::Compiler compiler;
+    auto result = compiler.Run(root_ / "app");
+
+    EXPECT_FALSE(result.ok);
+    ASSERT_EQ(result.diagnostics.size(), 1u);
+    EXPECT_EQ(result.diagnostics[0].offset, 11u);
+    EXPECT_EQ(result.diagnostics[0].message, "invalid UTF-8 byte 0xC0: overlong encoding");
+    EXPECT_FALSE(std::filesystem::exists(Driver::InterfacePath(root_ / "app")));
+}
+
+TEST(DriverSearchPath, Parse)
+{
+    auto paths = Driver::ParseSearchPath("/a::/b/c:");
+    ASSERT_EQ(paths.size(), 2u);
+    EXPECT_EQ(paths[0], "/a");
+    EXPECT_EQ(paths[1], "/b/c");
+    EXPECT_TRUE(Driver::ParseSearchPath(nullptr).empty());
+}
+
+//
+// Server
+//
+using DriverServer = Workspace;
+
+TEST_F(DriverServer, HandleRequests)
+{
+    auto app = Write("app/main.wfl", "func main() int32 { return 0; }").parent_path();
+    Driver::Server server(root_ / "waffle.sock");
+
+    EXPECT_TRUE(server.Handle(Driver::EncodeRequest("check", {app.string()})).starts_with("status ok"));
+    EXPECT_TRUE(server.Handle(Driver::EncodeRequest("frobnicate", {})).starts_with("status error"));
+    EXPECT_TRUE(server.Handle(Driver::EncodeRequest("build", {})).starts_with("status error"));
+    EXPECT_EQ(server.Handle(Driver::EncodeRequest("stats", {})), "status ok files=1 symbols=1\n");
+}
+
+TEST_F(DriverServer, SocketRoundTrip)
+{
+    auto app = Write("app/main.wfl", "func main() int32 { return 0; }").parent_path();
+    auto socket_path = root_ / "waffle.sock";
+    Driver::Server server(socket_path);
+    std::string error;
+    ASSERT_TRUE(server.Listen(error)) << error;
+    std::thread serving([&server] { server.Serve(); });
+
+    auto cold = Driver::SendRequest(socket_path, Driver::EncodeRequest("check", {app.string()}), error);
+    auto warm = Driver::SendRequest(socket_path, Driver::EncodeRequest("check", {app.string()}), error);
+    auto stop = Driver::SendRequest(socket_path, Driver::EncodeRequest("shutdown", {}), error);
+    serving.join();
+
+    ASSERT_TRUE(cold && warm && stop) << error;
+    EXPECT_NE(cold->find("lexed=1 reused=0"), std::string::npos);
+    // The package comes from its interface file, and its source stays in the daemon's cache
+    EXPECT_NE(warm->find("checked=0 files=0 lexed=0 reused=1"), std::string::npos) << *warm;
+    EXPECT_EQ(*stop, "status ok\n");
+}
+
+TEST_F(DriverServer, StalledClientIsDropped)
+{
+    auto socket_path = root_ / "waffle.sock";
+    Driver::Server server(socket_path);
+    server.SetRequestTimeout(std::chrono::milliseconds(100));
+    std::string error;
+    ASSERT_TRUE(server.Listen(error)) << error;
+    std::thread serving([&server] { server.Serve(); });
+
+    // Connects first and never finishes its request
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::strcpy(address.sun_path, socket_path.c_str());
+    int stalled = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    ASSERT_EQ(::connect(stalled, reinterpret_cast<sockaddr *>(&address), sizeof(address)), 0);
+    ASSERT_EQ(::send(stalled, "check\n", 6, 0), 6);
+
+    auto stop = Driver::SendRequest(socket_path, Driver::EncodeRequest("shutdown", {}), error);
+    serving.join();
+
+    ASSERT_TRUE(stop) << error;
+    EXPECT_EQ(*stop, "status ok\n");
+    char byte;
+    EXPECT_EQ(::recv(stalled, &byte, 1, 0), 0);
+    ::close(stalled);
+}
+
+TEST_F(DriverServer, ListenReplacesOnlyStaleSockets)
+{
+    std::string error;
+    auto regular = Write("precious.txt", "keep me");
+    EXPECT_FALSE(Driver::Server(regular).Listen(error));
+    EXPECT_EQ(error, regular.string() + " exists and is not a socket");
+    EXPECT_TRUE(std::filesystem::is_regular_file(regular));
+
+    auto socket_path = root_ / "waffle.sock";
+    {
+        Driver::Server running(socket_path);
+        ASSERT_TRUE(running.Listen(error)) << error;
+        Driver::Server second(socket_path);
+        EXPECT_FALSE(second.Listen(error));
+        EXPECT_EQ(error, "a server is already listening on " + socket_path.string());
+        EXPECT_TRUE(std::filesystem::is_socket(socket_path));
+    }
+
+    // A server that died without cleaning up leaves a socket file nobody answers on
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::strcpy(address.sun_path, socket_path.c_str());
+    int stale = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    ASSERT_EQ(::bind(stale, reinterpret_cast<sockaddr *>(&address), sizeof(address)), 0);
+    ::close(stale);
+    EXPECT_TRUE(Driver::Server(socket_path).Listen(error)) << error;
+}
@@ -0,0 +1,72 @@
+#include <Lexer/Lexer.h>
+#include <Lexer/Unicode.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <spanstream>
+#include <string>
+
+// Measures UTF-8 validation throughput per kernel and lexing throughput on ASCII and non-ASCII sources.
+// Usage: WaffleLexerBench [megabytes]
+namespace
+{
+    std::string Generate(std::size_t bytes, bool ascii)
+    {
+        std::string const line = ascii ? "func compute_total(int32 count, fp64 scale) fp64 { var sum = count * 2; }\n"
+                                       : "func größe_berechnen(int32 anzahl) fp64 { var π = 3.14; // ≈ π\n"
+                                         "    return \"ergebnis: 結果\"; }\n";
+        std::string text;
+        text.reserve(bytes + line.size());
+        while (text.size() < bytes) {
+            text += line;
+        }
+        return text;
+    }
+
+    template<typename F>
+    double BestSeconds(int runs, F f)
+    {
+        double best = 1e9;
+        for (int run = 0; run < runs; ++run) {
+            auto const start = std::chrono::steady_clock::now();
+            f();
+            best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        }
+        return best;
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    std::size_t const megabytes = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 64;
+
+    for (bool ascii: {true, false}) {
+        auto const text = Generate(megabytes << 20, ascii);
+        std::cout << (ascii ? "ascii" : "non-ascii") << " source, " << (text.size() >> 20) << " MiB\n";
+
+        for (auto kernel: {Lexer::Utf8Kernel::Scalar, Lexer::Utf8Kernel::Ssse3, Lexer::Utf8Kernel::Avx2}) {
+            if (!Lexer::IsSupported(kernel)) {
+                continue;
+            }
+            bool valid = false;
+            auto seconds = BestSeconds(5, [&] { valid = Lexer::IsValidUtf8(text, kernel); });
+            std::cout << "  validate " << std::left << std::setw(8) << kernel << std::right << std::fixed
+                      << std::setprecision(2) << std::setw(8) << text.size() / seconds / 1e9 << " GB/s"
+                      << (valid ? "" : "  (invalid?)") << "\n";
+        }
+
+        // Lexing is much slower, so a slice is enough
+        auto const slice = std::string_view(text).substr(0, std::min<std::size_t>(text.size(), 8 << 20));
+        std::size_t tokens = 0;
+        auto seconds = BestSeconds(3, [&] {
+            std::ispanstream input(std::span<char const>(slice.data(), slice.size()));
+            Lexer::Lexer lexer(input);
+            tokens = lexer.Tokenize().size();
+        });
+        std::cout << "  lex               " << std::setw(8) << slice.size() / seconds / 1e6 << " MB/s (" << tokens
+                  << " tokens)\n";
+    }
+    return 0;
+}
@@ -1,9 +1,12 @@
 #pragma once
 #include <Lexer/Types.h>
+#include <Lexer/Unicode.h>
 
 #include <deque>
 #include <istream>
+#include <memory_resource>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace Lexer
@@ -12,23 +15,32 @@ namespace Lexer
     class Lexer
     {
     public:
-        explicit Lexer(std::istream &input, std::string filename = "<memory>");
+        // Every buffer, lexeme and token produced by the lexer is allocated from `resource`, so a caller can hand in
+        // an arena and drop all of a file's tokens at once.
+        explicit Lexer(std::istream &input,
+                       std::string_view filename = "<memory>",
+                       std::pmr::memory_resource *resource = std::pmr::get_default_resource());
 
         Token Next();
         Token Peek(std::size_t lookahead = 0);
-        std::vector<Token> Tokenize();
+        std::pmr::vector<Token> Tokenize();
+
+        [[nodiscard]] std::pmr::memory_resource *Resource() const { return resource_; }
 
     private:
         std::istream &input_;
-        std::string filename_;
-        std::deque<char> buffer_;
+        std::pmr::memory_resource *resource_;
+        std::pmr::string filename_;
+        std::pmr::deque<char> buffer_;
+        std::pmr::deque<char> peek_buffer_; // Scratch buffer for Peek, kept empty between calls
         std::size_t current_pos_ = 0;
         std::size_t line_ = 1;
         std::size_t column_ = 1;
         bool eof_reached_ = false;
 
-        [[nodiscard]] Token MakeToken_(TokenKind kind, std::size_t start, std::string const &lexeme) const;
+        [[nodiscard]] Token MakeToken_(TokenKind kind, std::size_t start, std::string_view lexeme) const;
         [[nodiscard]] char PeekChar_(std::size_t offset = 0);
+        [[nodiscard]] DecodedChar PeekCodePoint_();
         char Advance_();
         bool Match_(std::string_view op);
         [[nodiscard]] static constexpr TokenKind LookupKeyword_(std::string_view text);
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <memory_resource>
 #include <ostream>
 #include <string>
 
@@ -86,7 +87,7 @@ namespace Lexer
 
     struct Span
     {
-        std::string file;
+        std::pmr::string file;
         size_t start;
         size_t length;
     };
@@ -94,7 +95,7 @@ namespace Lexer
     struct Token
     {
         TokenKind kind;
-        std::string lexeme;
+        std::pmr::string lexeme;
         Span span;
     };
 
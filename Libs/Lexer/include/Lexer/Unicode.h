@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+namespace Lexer
+{
+
+    enum class Utf8Problem : std::uint8_t
+    {
+        None,
+        UnexpectedContinuation,
+        InvalidByte,
+        Truncated,
+        Overlong,
+        Surrogate,
+        TooLarge
+    };
+
+    [[nodiscard]] std::string_view Describe(Utf8Problem problem);
+
+    struct DecodedChar
+    {
+        char32_t code_point = 0;
+        std::size_t length = 0;
+        Utf8Problem problem = Utf8Problem::None;
+    };
+
+    // Decodes the UTF-8 sequence at the start of a non-empty `text`. For an ill-formed sequence `length` covers its
+    // maximal valid prefix (at least one byte), so decoding can resume right after it.
+    [[nodiscard]] DecodedChar DecodeUtf8(std::string_view text);
+
+    // Implementations of the validation pass; the vector ones are picked at runtime when the CPU has them
+    enum class Utf8Kernel : std::uint8_t
+    {
+        Scalar,
+        Ssse3,
+        Avx2
+    };
+
+    std::ostream &operator<<(std::ostream &os, Utf8Kernel kernel);
+
+    [[nodiscard]] bool IsSupported(Utf8Kernel kernel);
+    [[nodiscard]] Utf8Kernel BestUtf8Kernel();
+
+    // Whether `text` is well-formed UTF-8: no stray or missing continuation bytes, overlong encodings, surrogates
+    // or code points above U+10FFFF.
+    [[nodiscard]] bool IsValidUtf8(std::string_view text);
+    [[nodiscard]] bool IsValidUtf8(std::string_view text, Utf8Kernel kernel);
+
+    struct Utf8Error
+    {
+        std::size_t offset; // of the first byte that is not part of a well-formed sequence
+        std::string message;
+    };
+
+    // Validates with the fastest kernel and only locates the error when there is one.
+    [[nodiscard]] std::optional<Utf8Error> ValidateUtf8(std::string_view text);
+
+    // UAX #31 identifier classes
+    [[nodiscard]] bool IsXidStart(char32_t code_point);
+    [[nodiscard]] bool IsXidContinue(char32_t code_point);
+
+} // namespace Lexer
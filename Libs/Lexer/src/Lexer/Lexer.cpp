@@ -1,7 +1,6 @@
 #include "Lexer/Lexer.h"
 #include <algorithm>
 #include <array>
-#include <cctype>
 #include <string_view>
 
 using namespace std::string_view_literals;
@@ -41,9 +40,23 @@ namespace Lexer
                  {"?"sv, TokenKind::Question},    {":"sv, TokenKind::Colon},     {"("sv, TokenKind::LParen},
                  {")"sv, TokenKind::RParen},      {"{"sv, TokenKind::LBrace},    {"}"sv, TokenKind::RBrace},
                  {","sv, TokenKind::Comma},       {";"sv, TokenKind::Semicolon}, {"."sv, TokenKind::Dot}});
+
+        // ASCII is classified directly, only bytes from 0x80 on go through the UTF-8 decoder and XID tables. The
+        // <cctype> functions would depend on the locale and are undefined for negative chars.
+        constexpr bool IsAscii(char c) { return static_cast<unsigned char>(c) < 0x80; }
+        constexpr bool IsDigit(char c) { return c >= '0' && c <= '9'; }
+        constexpr bool IsIdentStart(char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_'; }
+        constexpr bool IsIdentContinue(char c) { return IsIdentStart(c) || IsDigit(c); }
+        constexpr bool IsSpace(char c) { return c == ' ' || (c >= '\t' && c <= '\r'); }
     } // namespace Detail
 
-    Lexer::Lexer(std::istream &input, std::string filename) : input_(input), filename_(std::move(filename)) {}
+    Lexer::Lexer(std::istream &input, std::string_view filename, std::pmr::memory_resource *resource)
+        : input_(input)
+        , resource_(resource)
+        , filename_(filename, resource)
+        , buffer_(resource)
+        , peek_buffer_(resource)
+    {}
 
     Token Lexer::Next()
     {
@@ -58,43 +71,52 @@ namespace Lexer
 
     Token Lexer::Peek(std::size_t lookahead)
     {
-        // Simple implementation: save state, advance lookahead times, restore
+        // Save state, re-read from the stream into the scratch buffer, advance lookahead times, restore. Swapping
+        // the buffers instead of copying them keeps repeated Peek calls from growing the arena.
         auto saved_pos = current_pos_;
         auto saved_line = line_;
         auto saved_column = column_;
-        auto saved_buffer = buffer_;
+        auto saved_eof = eof_reached_;
+        buffer_.swap(peek_buffer_);
+        input_.clear();
+        input_.seekg(current_pos_);
+        eof_reached_ = false;
 
-        Token result{TokenKind::Eof, "", {filename_, current_pos_, 0}};
+        Token result = MakeToken_(TokenKind::Eof, current_pos_, "");
         for (std::size_t i = 0; i <= lookahead; ++i) {
             result = Next();
         }
 
-        // Restore state
+        // Restore state, the stream resumes right after the bytes that are still buffered
         current_pos_ = saved_pos;
         line_ = saved_line;
         column_ = saved_column;
-        buffer_ = saved_buffer;
+        eof_reached_ = saved_eof;
+        buffer_.clear();
+        buffer_.swap(peek_buffer_);
         input_.clear();
-        input_.seekg(current_pos_);
+        input_.seekg(static_cast<std::streamoff>(current_pos_ + buffer_.size()));
 
         return result;
     }
 
-    std::vector<Token> Lexer::Tokenize()
+    std::pmr::vector<Token> Lexer::Tokenize()
     {
-        std::vector<Token> tokens;
-        Token token;
+        std::pmr::vector<Token> tokens(resource_);
+        TokenKind kind;
         do {
-            token = Next();
-            tokens.push_back(token);
+            tokens.push_back(Next());
+            kind = tokens.back().kind;
         }
-        while (token.kind != TokenKind::Eof);
+        while (kind != TokenKind::Eof);
         return tokens;
     }
 
-    Token Lexer::MakeToken_(TokenKind kind, std::size_t start, std::string const &lexeme) const
+    Token Lexer::MakeToken_(TokenKind kind, std::size_t start, std::string_view lexeme) const
     {
-        return {kind, lexeme, {filename_, start, lexeme.length()}};
+        return {kind,
+                std::pmr::string(lexeme, resource_),
+                {std::pmr::string(filename_, resource_), start, lexeme.length()}};
     }
 
     char Lexer::PeekChar_(std::size_t offset)
@@ -125,7 +147,8 @@ namespace Lexer
             line_++;
             column_ = 1;
         }
-        else {
+        else if ((static_cast<unsigned char>(c) & 0xC0) != 0x80) {
+            // Columns count code points, so continuation bytes do not advance them
             column_++;
         }
 
@@ -155,6 +178,15 @@ namespace Lexer
         return it != Detail::kKeywords.end() ? it->second : TokenKind::Ident;
     }
 
+    DecodedChar Lexer::PeekCodePoint_()
+    {
+        EnsureBuffered_(4);
+        std::array<char, 4> bytes{};
+        auto const available = std::min(bytes.size(), buffer_.size());
+        std::copy_n(buffer_.begin(), available, bytes.begin());
+        return DecodeUtf8(std::string_view(bytes.data(), available));
+    }
+
     bool Lexer::Eof_() const { return eof_reached_ && buffer_.empty(); }
 
     void Lexer::EnsureBuffered_(std::size_t count)
@@ -188,17 +220,31 @@ namespace Lexer
         // Try operators (longest first)
         for (auto const &[op, kind]: Detail::kOperators) {
             if (Match_(op)) {
-                return MakeToken_(kind, start, std::string(op));
+                return MakeToken_(kind, start, op);
             }
         }
 
         c = PeekChar_();
 
-        if (std::isalpha(c) || c == '_') {
+        if (Detail::IsIdentStart(c)) {
             return ScanIdentifier_();
         }
 
-        if (std::isdigit(c)) {
+        if (!Detail::IsAscii(c)) {
+            auto const decoded = PeekCodePoint_();
+            if (decoded.problem == Utf8Problem::None && IsXidStart(decoded.code_point)) {
+                return ScanIdentifier_();
+            }
+
+            // A whole character (or ill-formed sequence) per error token, not one per byte
+            std::pmr::string lexeme(resource_);
+            for (std::size_t i = 0; i < decoded.length; ++i) {
+                lexeme += Advance_();
+            }
+            return MakeToken_(TokenKind::Error, start, lexeme);
+        }
+
+        if (Detail::IsDigit(c)) {
             return ScanNumber_();
         }
 
@@ -217,16 +263,31 @@ namespace Lexer
         }
 
         Advance_();
-        return MakeToken_(TokenKind::Error, start, std::string(1, c));
+        return MakeToken_(TokenKind::Error, start, std::string_view(&c, 1));
     }
 
     Token Lexer::ScanIdentifier_()
     {
         std::size_t start = current_pos_;
-        std::string lexeme;
+        std::pmr::string lexeme(resource_);
 
-        while (std::isalnum(PeekChar_()) || PeekChar_() == '_') {
-            lexeme += Advance_();
+        while (true) {
+            char const c = PeekChar_();
+            if (Detail::IsAscii(c)) {
+                if (!Detail::IsIdentContinue(c)) {
+                    break;
+                }
+                lexeme += Advance_();
+                continue;
+            }
+
+            auto const decoded = PeekCodePoint_();
+            if (decoded.problem != Utf8Problem::None || !IsXidContinue(decoded.code_point)) {
+                break;
+            }
+            for (std::size_t i = 0; i < decoded.length; ++i) {
+                lexeme += Advance_();
+            }
         }
 
         TokenKind kind = LookupKeyword_(lexeme);
@@ -236,17 +297,17 @@ namespace Lexer
     Token Lexer::ScanNumber_()
     {
         std::size_t start = current_pos_;
-        std::string lexeme;
+        std::pmr::string lexeme(resource_);
         bool is_float = false;
 
-        while (std::isdigit(PeekChar_())) {
+        while (Detail::IsDigit(PeekChar_())) {
             lexeme += Advance_();
         }
 
-        if (PeekChar_() == '.' && std::isdigit(PeekChar_(1))) {
+        if (PeekChar_() == '.' && Detail::IsDigit(PeekChar_(1))) {
             is_float = true;
             lexeme += Advance_(); // consume '.'
-            while (std::isdigit(PeekChar_())) {
+            while (Detail::IsDigit(PeekChar_())) {
                 lexeme += Advance_();
             }
         }
@@ -258,7 +319,22 @@ namespace Lexer
     Token Lexer::ScanString_()
     {
         std::size_t start = current_pos_;
-        std::string lexeme;
+        std::pmr::string lexeme(resource_);
+        bool well_formed = true;
+
+        // Consumes one character, which is a whole code point if it is not ASCII. Keeps going on ill-formed bytes
+        // so the string up to the closing quote is still a single token.
+        auto consume_char = [&] {
+            if (Detail::IsAscii(PeekChar_())) {
+                lexeme += Advance_();
+                return;
+            }
+            auto const decoded = PeekCodePoint_();
+            well_formed = well_formed && decoded.problem == Utf8Problem::None;
+            for (std::size_t i = 0; i < decoded.length; ++i) {
+                lexeme += Advance_();
+            }
+        };
 
         lexeme += Advance_(); // consume opening quote
 
@@ -266,15 +342,18 @@ namespace Lexer
             if (PeekChar_() == '\\') {
                 lexeme += Advance_(); // consume backslash
                 if (!Eof_()) {
-                    lexeme += Advance_(); // consume escaped character
+                    consume_char(); // consume escaped character
                 }
             }
             else {
-                lexeme += Advance_();
+                consume_char();
             }
         }
 
-        if (Eof_()) {
+        if (Eof_() || !well_formed) {
+            if (!Eof_()) {
+                lexeme += Advance_(); // consume closing quote
+            }
             return MakeToken_(TokenKind::Error, start, lexeme);
         }
 
@@ -309,7 +388,7 @@ namespace Lexer
 
     void Lexer::SkipWhitespace_()
     {
-        while (!Eof_() && std::isspace(PeekChar_())) {
+        while (!Eof_() && Detail::IsSpace(PeekChar_())) {
             Advance_();
         }
     }
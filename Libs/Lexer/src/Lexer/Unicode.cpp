@@ -0,0 +1,363 @@
+#include "Lexer/Unicode.h"
+#include "XidTables.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define WAFFLE_UTF8_X86 1
+#include <immintrin.h>
+#else
+#define WAFFLE_UTF8_X86 0
+#endif
+
+namespace Lexer
+{
+
+    namespace Detail
+    {
+        constexpr bool IsContinuation(unsigned char byte) { return (byte & 0xC0) == 0x80; }
+
+        bool IsAscii(std::string_view text, std::size_t pos)
+        {
+            std::uint64_t word;
+            std::memcpy(&word, text.data() + pos, sizeof(word));
+            return (word & 0x8080808080808080) == 0;
+        }
+
+        // Index of the first ill-formed sequence, or text.size()
+        std::size_t FindInvalidUtf8(std::string_view text)
+        {
+            std::size_t pos = 0;
+            while (pos < text.size()) {
+                if (pos + 8 <= text.size() && IsAscii(text, pos)) {
+                    pos += 8;
+                    continue;
+                }
+                if (static_cast<unsigned char>(text[pos]) < 0x80) {
+                    pos++;
+                    continue;
+                }
+                auto const decoded = DecodeUtf8(text.substr(pos));
+                if (decoded.problem != Utf8Problem::None) {
+                    return pos;
+                }
+                pos += decoded.length;
+            }
+            return pos;
+        }
+
+        bool InRanges(auto const &ranges, char32_t code_point)
+        {
+            auto it = std::ranges::upper_bound(ranges, code_point, {}, &CodePointRange::first);
+            return it != ranges.begin() && code_point <= std::prev(it)->last;
+        }
+
+#if WAFFLE_UTF8_X86
+        // Keiser & Lemire, "Validating UTF-8 In Less Than One Instruction Per Byte" (2021). Each byte is classified
+        // by three 16-entry tables, indexed by the high and low nibble of the previous byte and the high nibble of
+        // the current one; a bit set in all three lookups is an error. Sequences of three or four bytes are then
+        // checked by comparing where continuation bytes are required against where they occur.
+        constexpr std::uint8_t kTooShort = 1 << 0;     // lead byte followed by a non-continuation
+        constexpr std::uint8_t kTooLong = 1 << 1;      // continuation after an ASCII byte
+        constexpr std::uint8_t kOverlong3 = 1 << 2;    // 11100000 100_____
+        constexpr std::uint8_t kTooLarge = 1 << 3;     // 11110100 1001____ and above
+        constexpr std::uint8_t kSurrogate = 1 << 4;    // 11101101 101_____
+        constexpr std::uint8_t kOverlong2 = 1 << 5;    // 1100000_
+        constexpr std::uint8_t kTooLarge1000 = 1 << 6; // 11110101 and above
+        constexpr std::uint8_t kOverlong4 = 1 << 6;    // 11110000 1000____
+        constexpr std::uint8_t kTwoConts = 1 << 7;     // two continuations in a row
+        constexpr std::uint8_t kCarry = kTooShort | kTooLong | kTwoConts;
+
+        // clang-format off
+        constexpr std::array<std::uint8_t, 16> kByte1High{
+                // 0___ (ASCII)
+                kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong,
+                // 10__ (continuation)
+                kTwoConts, kTwoConts, kTwoConts, kTwoConts,
+                // 1100, 1101 (two byte lead)
+                kTooShort | kOverlong2, kTooShort,
+                // 1110 (three byte lead)
+                kTooShort | kOverlong3 | kSurrogate,
+                // 1111 (four byte lead)
+                kTooShort | kTooLarge | kTooLarge1000 | kOverlong4};
+
+        constexpr std::array<std::uint8_t, 16> kByte1Low{
+                kCarry | kOverlong3 | kOverlong2 | kOverlong4, // ____0000
+                kCarry | kOverlong2,                          // ____0001
+                kCarry, kCarry,                               // ____001_
+                kCarry | kTooLarge,                           // ____0100
+                kCarry | kTooLarge | kTooLarge1000,           // ____0101
+                kCarry | kTooLarge | kTooLarge1000,           // ____011_
+                kCarry | kTooLarge | kTooLarge1000,
+                kCarry | kTooLarge | kTooLarge1000,           // ____1___
+                kCarry | kTooLarge | kTooLarge1000,
+                kCarry | kTooLarge | kTooLarge1000,
+                kCarry | kTooLarge | kTooLarge1000,
+                kCarry | kTooLarge | kTooLarge1000,
+                kCarry | kTooLarge | kTooLarge1000 | kSurrogate, // ____1101
+                kCarry | kTooLarge | kTooLarge1000,
+                kCarry | kTooLarge | kTooLarge1000};
+
+        constexpr std::array<std::uint8_t, 16> kByte2High{
+                // 0___ (ASCII)
+                kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort,
+                // 1000
+                kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge1000 | kOverlong4,
+                // 1001
+                kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge,
+                // 101_
+                kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge,
+                kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge,
+                // 11__ (lead)
+                kTooShort, kTooShort, kTooShort, kTooShort};
+        // clang-format on
+
+        // The last bytes of a block that start a sequence running into the next block
+        constexpr std::array<std::uint8_t, 32> kIncompleteThreshold = [] {
+            std::array<std::uint8_t, 32> max{};
+            max.fill(0xFF);
+            max[29] = 0b11110000 - 1;
+            max[30] = 0b11100000 - 1;
+            max[31] = 0b11000000 - 1;
+            return max;
+        }();
+
+        // Both kernels run the same steps, on 16 or 32 bytes per block. vpshufb looks up within each 128-bit lane,
+        // so the AVX2 kernel replicates the nibble tables into both lanes.
+        __attribute__((target("ssse3"))) bool IsValidUtf8Ssse3(std::string_view text)
+        {
+            auto const byte_1_high = _mm_loadu_si128(reinterpret_cast<__m128i const *>(kByte1High.data()));
+            auto const byte_1_low = _mm_loadu_si128(reinterpret_cast<__m128i const *>(kByte1Low.data()));
+            auto const byte_2_high = _mm_loadu_si128(reinterpret_cast<__m128i const *>(kByte2High.data()));
+            auto const incomplete_max =
+                    _mm_loadu_si128(reinterpret_cast<__m128i const *>(kIncompleteThreshold.data() + 16));
+            auto const nibble = _mm_set1_epi8(0x0F);
+
+            __m128i error = _mm_setzero_si128();
+            __m128i prev_input = _mm_setzero_si128();
+            __m128i prev_incomplete = _mm_setzero_si128();
+
+            auto const block = [&](char const *data) __attribute__((target("ssse3"))) {
+                auto const input = _mm_loadu_si128(reinterpret_cast<__m128i const *>(data));
+                if (_mm_movemask_epi8(input) == 0) {
+                    // ASCII only: just check that the previous block did not end mid-sequence
+                    error = _mm_or_si128(error, prev_incomplete);
+                    return;
+                }
+                auto const prev1 = _mm_alignr_epi8(input, prev_input, 16 - 1);
+                auto const prev2 = _mm_alignr_epi8(input, prev_input, 16 - 2);
+                auto const prev3 = _mm_alignr_epi8(input, prev_input, 16 - 3);
+                auto const special = _mm_and_si128(
+                        _mm_and_si128(_mm_shuffle_epi8(byte_1_high, _mm_and_si128(_mm_srli_epi16(prev1, 4), nibble)),
+                                      _mm_shuffle_epi8(byte_1_low, _mm_and_si128(prev1, nibble))),
+                        _mm_shuffle_epi8(byte_2_high, _mm_and_si128(_mm_srli_epi16(input, 4), nibble)));
+                auto const third = _mm_subs_epu8(prev2, _mm_set1_epi8(0b11100000 - 0x80));
+                auto const fourth = _mm_subs_epu8(prev3, _mm_set1_epi8(0b11110000 - 0x80));
+                auto const must_continue = _mm_and_si128(_mm_or_si128(third, fourth), _mm_set1_epi8(kTwoConts));
+                error = _mm_or_si128(error, _mm_xor_si128(must_continue, special));
+                prev_incomplete = _mm_subs_epu8(input, incomplete_max);
+                prev_input = input;
+            };
+
+            std::size_t pos = 0;
+            for (; pos + 16 <= text.size(); pos += 16) {
+                block(text.data() + pos);
+            }
+            if (pos < text.size()) {
+                // Pad the tail with ASCII zeros
+                char tail[16] = {};
+                std::memcpy(tail, text.data() + pos, text.size() - pos);
+                block(tail);
+            }
+            error = _mm_or_si128(error, prev_incomplete);
+            return _mm_movemask_epi8(_mm_cmpeq_epi8(error, _mm_setzero_si128())) == 0xFFFF;
+        }
+
+        __attribute__((target("avx2"))) bool IsValidUtf8Avx2(std::string_view text)
+        {
+            auto const byte_1_high = _mm256_broadcastsi128_si256(
+                    _mm_loadu_si128(reinterpret_cast<__m128i const *>(kByte1High.data())));
+            auto const byte_1_low = _mm256_broadcastsi128_si256(
+                    _mm_loadu_si128(reinterpret_cast<__m128i const *>(kByte1Low.data())));
+            auto const byte_2_high = _mm256_broadcastsi128_si256(
+                    _mm_loadu_si128(reinterpret_cast<__m128i const *>(kByte2High.data())));
+            auto const incomplete_max =
+                    _mm256_loadu_si256(reinterpret_cast<__m256i const *>(kIncompleteThreshold.data()));
+            auto const nibble = _mm256_set1_epi8(0x0F);
+
+            __m256i error = _mm256_setzero_si256();
+            __m256i prev_input = _mm256_setzero_si256();
+            __m256i prev_incomplete = _mm256_setzero_si256();
+
+            auto const block = [&](char const *data) __attribute__((target("avx2"))) {
+                auto const input = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(data));
+                if (_mm256_movemask_epi8(input) == 0) {
+                    error = _mm256_or_si256(error, prev_incomplete);
+                    return;
+                }
+                // The previous block's upper lane followed by this block's lower lane, to shift bytes across lanes
+                auto const shifted = _mm256_permute2x128_si256(prev_input, input, 0x21);
+                auto const prev1 = _mm256_alignr_epi8(input, shifted, 16 - 1);
+                auto const prev2 = _mm256_alignr_epi8(input, shifted, 16 - 2);
+                auto const prev3 = _mm256_alignr_epi8(input, shifted, 16 - 3);
+                auto const special = _mm256_and_si256(
+                        _mm256_and_si256(
+                                _mm256_shuffle_epi8(byte_1_high, _mm256_and_si256(_mm256_srli_epi16(prev1, 4), nibble)),
+                                _mm256_shuffle_epi8(byte_1_low, _mm256_and_si256(prev1, nibble))),
+                        _mm256_shuffle_epi8(byte_2_high, _mm256_and_si256(_mm256_srli_epi16(input, 4), nibble)));
+                auto const third = _mm256_subs_epu8(prev2, _mm256_set1_epi8(0b11100000 - 0x80));
+                auto const fourth = _mm256_subs_epu8(prev3, _mm256_set1_epi8(0b11110000 - 0x80));
+                auto const must_continue =
+                        _mm256_and_si256(_mm256_or_si256(third, fourth), _mm256_set1_epi8(kTwoConts));
+                error = _mm256_or_si256(error, _mm256_xor_si256(must_continue, special));
+                prev_incomplete = _mm256_subs_epu8(input, incomplete_max);
+                prev_input = input;
+            };
+
+            std::size_t pos = 0;
+            for (; pos + 32 <= text.size(); pos += 32) {
+                block(text.data() + pos);
+            }
+            if (pos < text.size()) {
+                char tail[32] = {};
+                std::memcpy(tail, text.data() + pos, text.size() - pos);
+                block(tail);
+            }
+            error = _mm256_or_si256(error, prev_incomplete);
+            return _mm256_testz_si256(error, error) != 0;
+        }
+#endif
+    } // namespace Detail
+
+    std::string_view Describe(Utf8Problem problem)
+    {
+        switch (problem) {
+            case Utf8Problem::None: return "valid";
+            case Utf8Problem::UnexpectedContinuation: return "unexpected continuation byte";
+            case Utf8Problem::InvalidByte: return "byte never valid in UTF-8";
+            case Utf8Problem::Truncated: return "incomplete sequence";
+            case Utf8Problem::Overlong: return "overlong encoding";
+            case Utf8Problem::Surrogate: return "encoded surrogate";
+            case Utf8Problem::TooLarge: return "code point above U+10FFFF";
+        }
+        return "unknown";
+    }
+
+    DecodedChar DecodeUtf8(std::string_view text)
+    {
+        auto const byte = [&](std::size_t i) { return static_cast<unsigned char>(text[i]); };
+        auto const lead = byte(0);
+        if (lead < 0x80) {
+            return {lead, 1};
+        }
+        if (Detail::IsContinuation(lead)) {
+            return {0, 1, Utf8Problem::UnexpectedContinuation};
+        }
+        if (lead < 0xC2) {
+            return {0, 1, Utf8Problem::Overlong};
+        }
+        if (lead > 0xF4) {
+            return {0, 1, Utf8Problem::InvalidByte};
+        }
+
+        std::size_t const length = lead < 0xE0 ? 2 : lead < 0xF0 ? 3 : 4;
+        char32_t code_point = lead & (0x7F >> length);
+        for (std::size_t i = 1; i < length; ++i) {
+            if (i >= text.size() || !Detail::IsContinuation(byte(i))) {
+                return {0, i, Utf8Problem::Truncated};
+            }
+            // The second byte's range depends on the lead byte (Unicode table 3-7)
+            if (i == 1) {
+                auto const second = byte(1);
+                if ((lead == 0xE0 && second < 0xA0) || (lead == 0xF0 && second < 0x90)) {
+                    return {0, 1, Utf8Problem::Overlong};
+                }
+                if (lead == 0xED && second > 0x9F) {
+                    return {0, 1, Utf8Problem::Surrogate};
+                }
+                if (lead == 0xF4 && second > 0x8F) {
+                    return {0, 1, Utf8Problem::TooLarge};
+                }
+            }
+            code_point = code_point << 6 | (byte(i) & 0x3F);
+        }
+        return {code_point, length};
+    }
+
+    std::ostream &operator<<(std::ostream &os, Utf8Kernel kernel)
+    {
+        switch (kernel) {
+            case Utf8Kernel::Scalar: return os << "scalar";
+            case Utf8Kernel::Ssse3: return os << "ssse3";
+            case Utf8Kernel::Avx2: return os << "avx2";
+        }
+        return os << "unknown";
+    }
+
+    bool IsSupported(Utf8Kernel kernel)
+    {
+        switch (kernel) {
+            case Utf8Kernel::Scalar: return true;
+#if WAFFLE_UTF8_X86
+            case Utf8Kernel::Ssse3: return __builtin_cpu_supports("ssse3");
+            case Utf8Kernel::Avx2: return __builtin_cpu_supports("avx2");
+#endif
+            default: return false;
+        }
+    }
+
+    Utf8Kernel BestUtf8Kernel()
+    {
+        static Utf8Kernel const best = IsSupported(Utf8Kernel::Avx2)    ? Utf8Kernel::Avx2
+                                       : IsSupported(Utf8Kernel::Ssse3) ? Utf8Kernel::Ssse3
+                                                                        : Utf8Kernel::Scalar;
+        return best;
+    }
+
+    bool IsValidUtf8(std::string_view text) { return IsValidUtf8(text, BestUtf8Kernel()); }
+
+    bool IsValidUtf8(std::string_view text, Utf8Kernel kernel)
+    {
+        switch (kernel) {
+#if WAFFLE_UTF8_X86
+            case Utf8Kernel::Ssse3: return Detail::IsValidUtf8Ssse3(text);
+            case Utf8Kernel::Avx2: return Detail::IsValidUtf8Avx2(text);
+#endif
+            default: return Detail::FindInvalidUtf8(text) == text.size();
+        }
+    }
+
+    std::optional<Utf8Error> ValidateUtf8(std::string_view text)
+    {
+        if (IsValidUtf8(text)) {
+            return std::nullopt;
+        }
+
+        // Only the slow path pays for finding the error
+        auto const offset = Detail::FindInvalidUtf8(text);
+        auto const problem = DecodeUtf8(text.substr(offset)).problem;
+        char byte[8];
+        std::snprintf(byte, sizeof(byte), "0x%02X", static_cast<unsigned char>(text[offset]));
+        return Utf8Error{offset, "invalid UTF-8 byte " + std::string(byte) + ": " + std::string(Describe(problem))};
+    }
+
+    bool IsXidStart(char32_t code_point)
+    {
+        if (code_point < 0x80) {
+            return (code_point >= 'a' && code_point <= 'z') || (code_point >= 'A' && code_point <= 'Z');
+        }
+        return Detail::InRanges(Detail::kXidStart, code_point);
+    }
+
+    bool IsXidContinue(char32_t code_point)
+    {
+        if (code_point < 0x80) {
+            return IsXidStart(code_point) || (code_point >= '0' && code_point <= '9') || code_point == '_';
+        }
+        return Detail::InRanges(Detail::kXidContinue, code_point);
+    }
+
+} // namespace Lexer
@@ -1,6 +1,10 @@
 #include <Lexer/Lexer.h>
 #include <gtest/gtest.h>
 
+#include <array>
+#include <memory_resource>
+#include <random>
+
 //
 // Identifiers
 //
@@ -305,3 +309,208 @@ TEST(LexerMisc, MultipleEofCalls)
     auto again = lx.Next();
     ASSERT_EQ(again.kind, Lexer::TokenKind::Eof);
 }
+
+TEST(LexerMisc, PeekDoesNotConsume)
+{
+    auto text = std::istringstream("a+b");
+    Lexer::Lexer lx(text);
+
+    ASSERT_EQ(lx.Next().lexeme, "a");
+    EXPECT_EQ(lx.Peek().kind, Lexer::TokenKind::Plus);
+    EXPECT_EQ(lx.Peek(1).lexeme, "b");
+    EXPECT_EQ(lx.Peek(2).kind, Lexer::TokenKind::Eof);
+
+    auto plus = lx.Next();
+    EXPECT_EQ(plus.kind, Lexer::TokenKind::Plus);
+    EXPECT_EQ(plus.span.start, 1u);
+    EXPECT_EQ(lx.Next().lexeme, "b");
+    EXPECT_EQ(lx.Next().kind, Lexer::TokenKind::Eof);
+}
+
+//
+// Allocation
+//
+TEST(LexerAllocation, PeekDoesNotGrowArena)
+{
+    // Each Peek used to copy the look-ahead buffer into the arena; a thousand of them would exhaust this one
+    std::array<std::byte, 1 << 14> storage{};
+    std::pmr::monotonic_buffer_resource arena(storage.data(), storage.size(), std::pmr::null_memory_resource());
+
+    auto text = std::istringstream("x + y");
+    Lexer::Lexer lx(text, "<memory>", &arena);
+    EXPECT_NO_THROW({
+        ASSERT_EQ(lx.Next().lexeme, "x");
+        for (int i = 0; i < 1000; ++i) {
+            ASSERT_EQ(lx.Peek().kind, Lexer::TokenKind::Plus);
+        }
+    });
+}
+
+TEST(LexerAllocation, AllAllocationsUseResource)
+{
+    // Any allocation that bypasses the arena hits the null resource and throws
+    std::array<std::byte, 1 << 16> storage{};
+    std::pmr::monotonic_buffer_resource arena(storage.data(), storage.size(), std::pmr::null_memory_resource());
+    auto *previous_default = std::pmr::set_default_resource(std::pmr::null_memory_resource());
+
+    auto text = std::istringstream("func main_with_a_long_name() int32 { return \"a string literal that is long\"; }");
+    Lexer::Lexer lx(text, "a/file/name/long/enough/to/avoid/sso.wfl", &arena);
+    EXPECT_NO_THROW({
+        auto toks = lx.Tokenize();
+        EXPECT_EQ(toks[1].lexeme, "main_with_a_long_name");
+        EXPECT_EQ(toks[1].span.file, "a/file/name/long/enough/to/avoid/sso.wfl");
+        EXPECT_EQ(toks.back().kind, Lexer::TokenKind::Eof);
+    });
+
+    std::pmr::set_default_resource(previous_default);
+}
+
+//
+// Unicode
+//
+TEST(LexerUnicode, XidIdentifiers)
+{
+    auto text = std::istringstream("größe π_2 имя 変数 a\u0301");
+    Lexer::Lexer lx(text);
+    auto toks = lx.Tokenize();
+
+    ASSERT_EQ(toks.size(), 6u);
+    for (std::size_t i = 0; i < 5; ++i) {
+        EXPECT_EQ(toks[i].kind, Lexer::TokenKind::Ident) << toks[i].lexeme;
+    }
+    EXPECT_EQ(toks[0].lexeme, "größe");
+    EXPECT_EQ(toks[1].lexeme, "π_2");
+    EXPECT_EQ(toks[1].span.start, 8u);
+    EXPECT_EQ(toks[1].span.length, 4u);
+    EXPECT_EQ(toks[3].lexeme, "変数");
+}
+
+TEST(LexerUnicode, NonIdentifierCharacterIsOneToken)
+{
+    // U+2192 RIGHTWARDS ARROW is not an identifier character, and cannot continue one either
+    auto text = std::istringstream("a→b");
+    Lexer::Lexer lx(text);
+    auto toks = lx.Tokenize();
+
+    ASSERT_EQ(toks.size(), 4u);
+    EXPECT_EQ(toks[0].lexeme, "a");
+    EXPECT_EQ(toks[1].kind, Lexer::TokenKind::Error);
+    EXPECT_EQ(toks[1].lexeme, "→");
+    EXPECT_EQ(toks[2].lexeme, "b");
+}
+
+TEST(LexerUnicode, InvalidBytesAreErrors)
+{
+    auto text = std::istringstream("x \xE2\x82 \xFF y");
+    Lexer::Lexer lx(text);
+    auto toks = lx.Tokenize();
+
+    ASSERT_EQ(toks.size(), 5u);
+    EXPECT_EQ(toks[1].kind, Lexer::TokenKind::Error);
+    EXPECT_EQ(toks[1].span.start, 2u);
+    EXPECT_EQ(toks[1].span.length, 2u);
+    EXPECT_EQ(toks[2].kind, Lexer::TokenKind::Error);
+    EXPECT_EQ(toks[2].span.start, 5u);
+    EXPECT_EQ(toks[3].lexeme, "y");
+}
+
+TEST(LexerUnicode, Strings)
+{
+    auto text = std::istringstream("\"héllo wörld\" \"bad \xC0\xAF\" 1");
+    Lexer::Lexer lx(text);
+    auto toks = lx.Tokenize();
+
+    ASSERT_EQ(toks.size(), 4u);
+    EXPECT_EQ(toks[0].kind, Lexer::TokenKind::StringLiteral);
+    EXPECT_EQ(toks[0].lexeme, "\"héllo wörld\"");
+    EXPECT_EQ(toks[1].kind, Lexer::TokenKind::Error);
+    EXPECT_EQ(toks[2].kind, Lexer::TokenKind::IntLiteral);
+}
+
+TEST(LexerUnicode, EscapedNonAsciiCharacter)
+{
+    auto text = std::istringstream("\"\\é\\\xE2\x82\xAC\" 1");
+    Lexer::Lexer lx(text);
+    auto toks = lx.Tokenize();
+
+    ASSERT_EQ(toks.size(), 3u);
+    EXPECT_EQ(toks[0].kind, Lexer::TokenKind::StringLiteral);
+    EXPECT_EQ(toks[0].lexeme, "\"\\é\\€\"");
+    EXPECT_EQ(toks[1].kind, Lexer::TokenKind::IntLiteral);
+}
+
+TEST(LexerUnicode, DecodeUtf8)
+{
+    using Lexer::Utf8Problem;
+    auto decode = [](std::string_view text) { return Lexer::DecodeUtf8(text); };
+
+    EXPECT_EQ(decode("A").code_point, U'A');
+    EXPECT_EQ(decode("é").code_point, U'é');
+    EXPECT_EQ(decode("€").length, 3u);
+    EXPECT_EQ(decode("\xF0\x9F\x98\x80").code_point, U'\U0001F600');
+
+    EXPECT_EQ(decode("\x80").problem, Utf8Problem::UnexpectedContinuation);
+    EXPECT_EQ(decode("\xC1\xBF").problem, Utf8Problem::Overlong);
+    EXPECT_EQ(decode("\xE0\x80\x80").problem, Utf8Problem::Overlong);
+    EXPECT_EQ(decode("\xED\xA0\x80").problem, Utf8Problem::Surrogate);
+    EXPECT_EQ(decode("\xF4\x90\x80\x80").problem, Utf8Problem::TooLarge);
+    EXPECT_EQ(decode("\xF8").problem, Utf8Problem::InvalidByte);
+
+    auto truncated = decode("\xF0\x9F\x98");
+    EXPECT_EQ(truncated.problem, Utf8Problem::Truncated);
+    EXPECT_EQ(truncated.length, 3u);
+}
+
+TEST(LexerUnicode, ValidateReportsFirstInvalidByte)
+{
+    EXPECT_FALSE(Lexer::ValidateUtf8("plain ascii, é, 変数, \xF0\x9F\x98\x80"));
+
+    std::string text(100, 'a');
+    text += "é";
+    text += "\xE2\x82(";
+    text += std::string(100, 'b') + "\xFF";
+    auto error = Lexer::ValidateUtf8(text);
+    ASSERT_TRUE(error);
+    EXPECT_EQ(error->offset, 102u);
+    EXPECT_EQ(error->message, "invalid UTF-8 byte 0xE2: incomplete sequence");
+}
+
+TEST(LexerUnicode, KernelsAgreeWithScalar)
+{
+    // Fragments that straddle block boundaries at every alignment, valid and invalid
+    std::vector<std::string> const fragments = {
+            "a",        "é",           "€",           "\xF0\x9F\x98\x80", "\xF4\x8F\xBF\xBF", "\xEF\xBF\xBF",
+            "\x80",     "\xC0\x80",   "\xE0\x9F\xBF", "\xED\xA0\x80",   "\xF4\x90\x80\x80", "\xF5",
+            "\xE2\x82", "\xF0\x9F\x98", "\xC3",       "\xFF"};
+
+    std::mt19937 rng(7);
+    for (int round = 0; round < 4000; ++round) {
+        std::string text;
+        auto const pieces = rng() % 80;
+        for (std::size_t i = 0; i < pieces; ++i) {
+            // Mostly valid pieces, so that an invalid one often comes after long valid runs
+            auto const index = rng() % 8 == 0 ? rng() % fragments.size() : rng() % 6;
+            text += fragments[index];
+        }
+
+        bool const expected = Lexer::IsValidUtf8(text, Lexer::Utf8Kernel::Scalar);
+        for (auto kernel: {Lexer::Utf8Kernel::Ssse3, Lexer::Utf8Kernel::Avx2}) {
+            if (Lexer::IsSupported(kernel)) {
+                ASSERT_EQ(Lexer::IsValidUtf8(text, kernel), expected) << kernel << " on round " << round;
+            }
+        }
+    }
+}
+
+TEST(LexerUnicode, XidTables)
+{
+    EXPECT_TRUE(Lexer::IsXidStart(U'ß'));
+    EXPECT_TRUE(Lexer::IsXidStart(U'変'));
+    EXPECT_FALSE(Lexer::IsXidStart(U'_'));
+    EXPECT_FALSE(Lexer::IsXidStart(U'\u0301')); // combining acute accent
+    EXPECT_TRUE(Lexer::IsXidContinue(U'\u0301'));
+    EXPECT_FALSE(Lexer::IsXidStart(U'٣'));      // Arabic-Indic digit three
+    EXPECT_TRUE(Lexer::IsXidContinue(U'٣'));
+    EXPECT_FALSE(Lexer::IsXidContinue(U'→'));
+    EXPECT_FALSE(Lexer::IsXidContinue(U'\U0010FFFF'));
+}
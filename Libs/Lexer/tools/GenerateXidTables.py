@@ -0,0 +1,61 @@
+#!/usr/bin/env python3
+"""Generates src/Lexer/XidTables.h from the Unicode database of the running Python.
+
+str.isidentifier() implements XID_Start/XID_Continue (UAX #31), so the tables cover the same identifiers as Python's
+own. Only code points from U+0080 on are listed, ASCII is classified by the lexer directly.
+
+Usage: python3 tools/GenerateXidTables.py > src/Lexer/XidTables.h
+"""
+import sys
+import unicodedata
+
+
+def ranges(predicate):
+    result = []
+    for cp in range(0x80, sys.maxunicode + 1):
+        if not predicate(chr(cp)):
+            continue
+        if result and result[-1][1] == cp - 1:
+            result[-1][1] = cp
+        else:
+            result.append([cp, cp])
+    return result
+
+
+def emit(name, table):
+    print(f"        constexpr std::array<CodePointRange, {len(table)}> {name}{{{{")
+    entries = [f"{{0x{lo:04X}, 0x{hi:04X}}}," for lo, hi in table]
+    per_line = 5
+    for i in range(0, len(entries), per_line):
+        print("                " + " ".join(entries[i:i + per_line]))
+    print("        }};")
+
+
+def main():
+    print("#pragma once")
+    print(f"// Generated by tools/GenerateXidTables.py from Unicode {unicodedata.unidata_version}. Do not edit.")
+    print()
+    print("#include <array>")
+    print()
+    print("namespace Lexer")
+    print("{")
+    print()
+    print("    namespace Detail")
+    print("    {")
+    print("        struct CodePointRange")
+    print("        {")
+    print("            char32_t first;")
+    print("            char32_t last;")
+    print("        };")
+    print()
+    emit("kXidStart", ranges(lambda c: c.isidentifier()))
+    print()
+    emit("kXidContinue", ranges(lambda c: ("a" + c).isidentifier()))
+    print()
+    print("    } // namespace Detail")
+    print()
+    print("} // namespace Lexer")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <ostream>
+
+namespace Memory
+{
+
+    struct AllocationStats
+    {
+        std::size_t allocations = 0;
+        std::size_t deallocations = 0;
+        std::size_t bytes_allocated = 0;
+        std::size_t bytes_in_use = 0;
+        std::size_t peak_bytes_in_use = 0;
+    };
+
+    std::ostream &operator<<(std::ostream &os, AllocationStats const &stats);
+
+    // Forwards every request to an upstream resource and records what went through it. Placed above an arena it
+    // measures what a phase asked for, placed below it measures how often the arena hit the system allocator.
+    class CountingResource : public std::pmr::memory_resource
+    {
+    public:
+        explicit CountingResource(std::pmr::memory_resource *upstream = std::pmr::get_default_resource());
+
+        [[nodiscard]] AllocationStats const &Stats() const { return stats_; }
+        [[nodiscard]] std::pmr::memory_resource *Upstream() const { return upstream_; }
+        void Reset();
+
+    private:
+        std::pmr::memory_resource *upstream_;
+        AllocationStats stats_;
+
+        void *do_allocate(std::size_t bytes, std::size_t alignment) override;
+        void do_deallocate(void *p, std::size_t bytes, std::size_t alignment) override;
+        [[nodiscard]] bool do_is_equal(std::pmr::memory_resource const &other) const noexcept override;
+    };
+
+    // Monotonic arena owning everything allocated for a single source file. The initial block is sized from the
+    // file size so a whole front-end pass normally needs a single upstream allocation, and dropping the arena
+    // releases all of it at once.
+    class FileArena
+    {
+    public:
+        explicit FileArena(std::size_t source_size,
+                           std::pmr::memory_resource *upstream = std::pmr::new_delete_resource());
+
+        FileArena(FileArena const &) = delete;
+        FileArena &operator=(FileArena const &) = delete;
+
+        [[nodiscard]] std::pmr::memory_resource *Resource() { return &arena_; }
+        [[nodiscard]] AllocationStats const &UpstreamStats() const { return upstream_.Stats(); }
+        void Release();
+
+        [[nodiscard]] static constexpr std::size_t InitialSize(std::size_t source_size)
+        {
+            return kBaseSize + source_size * kBytesPerSourceByte;
+        }
+
+    private:
+        // Rough upper bound of front-end memory per input byte (token storage, lexemes and container growth).
+        static constexpr std::size_t kBytesPerSourceByte = 64;
+        static constexpr std::size_t kBaseSize = 4096;
+
+        CountingResource upstream_;
+        std::pmr::monotonic_buffer_resource arena_;
+    };
+
+} // namespace Memory
@@ -0,0 +1,47 @@
+#include <Memory/Arena.h>
+
+#include <algorithm>
+
+namespace Memory
+{
+
+    std::ostream &operator<<(std::ostream &os, AllocationStats const &stats)
+    {
+        return os << stats.allocations << " allocations, " << stats.deallocations << " deallocations, "
+                  << stats.bytes_allocated << " bytes allocated, " << stats.peak_bytes_in_use << " bytes peak";
+    }
+
+    CountingResource::CountingResource(std::pmr::memory_resource *upstream) : upstream_(upstream) {}
+
+    void CountingResource::Reset() { stats_ = {}; }
+
+    void *CountingResource::do_allocate(std::size_t bytes, std::size_t alignment)
+    {
+        void *p = upstream_->allocate(bytes, alignment);
+        stats_.allocations++;
+        stats_.bytes_allocated += bytes;
+        stats_.bytes_in_use += bytes;
+        stats_.peak_bytes_in_use = std::max(stats_.peak_bytes_in_use, stats_.bytes_in_use);
+        return p;
+    }
+
+    void CountingResource::do_deallocate(void *p, std::size_t bytes, std::size_t alignment)
+    {
+        upstream_->deallocate(p, bytes, alignment);
+        stats_.deallocations++;
+        stats_.bytes_in_use -= std::min(bytes, stats_.bytes_in_use);
+    }
+
+    bool CountingResource::do_is_equal(std::pmr::memory_resource const &other) const noexcept
+    {
+        return this == &other;
+    }
+
+    FileArena::FileArena(std::size_t source_size, std::pmr::memory_resource *upstream)
+        : upstream_(upstream)
+        , arena_(InitialSize(source_size), &upstream_)
+    {}
+
+    void FileArena::Release() { arena_.release(); }
+
+} // namespace Memory
@@ -0,0 +1,71 @@
+#include <Memory/Arena.h>
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+//
+// CountingResource
+//
+TEST(MemoryCountingResource, CountsAllocations)
+{
+    Memory::CountingResource counting;
+    {
+        std::pmr::vector<int> values(&counting);
+        values.reserve(16);
+        values.reserve(64);
+    }
+
+    auto const &stats = counting.Stats();
+    EXPECT_EQ(stats.allocations, 2u);
+    EXPECT_EQ(stats.deallocations, 2u);
+    EXPECT_EQ(stats.bytes_allocated, 80 * sizeof(int));
+    EXPECT_EQ(stats.bytes_in_use, 0u);
+    EXPECT_EQ(stats.peak_bytes_in_use, 80 * sizeof(int));
+}
+
+TEST(MemoryCountingResource, Reset)
+{
+    Memory::CountingResource counting;
+    std::pmr::string text("a string that does not fit into the small buffer", &counting);
+    counting.Reset();
+
+    EXPECT_EQ(counting.Stats().allocations, 0u);
+    EXPECT_EQ(counting.Stats().bytes_in_use, 0u);
+}
+
+//
+// FileArena
+//
+TEST(MemoryFileArena, SingleUpstreamAllocation)
+{
+    constexpr std::size_t kSourceSize = 4096;
+    Memory::FileArena arena(kSourceSize);
+
+    std::pmr::vector<std::pmr::string> strings(arena.Resource());
+    for (int i = 0; i < 256; ++i) {
+        strings.emplace_back("a string that does not fit into the small buffer");
+    }
+
+    EXPECT_EQ(arena.UpstreamStats().allocations, 1u);
+}
+
+TEST(MemoryFileArena, GrowsWhenHintIsTooSmall)
+{
+    Memory::FileArena arena(0);
+    for (std::size_t i = 0; i < 16; ++i) {
+        EXPECT_NE(arena.Resource()->allocate(Memory::FileArena::InitialSize(0) / 2), nullptr);
+    }
+
+    EXPECT_GT(arena.UpstreamStats().allocations, 1u);
+}
+
+TEST(MemoryFileArena, ReleaseReturnsEverything)
+{
+    Memory::FileArena arena(128);
+    std::pmr::string text("a string that does not fit into the small buffer", arena.Resource());
+    arena.Release();
+
+    EXPECT_EQ(arena.UpstreamStats().bytes_in_use, 0u);
+    EXPECT_EQ(arena.UpstreamStats().allocations, arena.UpstreamStats().deallocations);
+}
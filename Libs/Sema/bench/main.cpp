@@ -0,0 +1,325 @@
+#include <Sema/TypeTable.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+// Measures type checking throughput on generated expression-heavy code, once with interned type ids and once with
+// types as structural trees compared by name, the representation the table replaces.
+// Usage: WaffleSemaBench [statements]
+namespace
+{
+    // Expressions in postfix order, as a checker walks them bottom-up
+    enum class Op : std::uint8_t
+    {
+        Push,    // operand of type `type`
+        Arith,   // pop two, push their common type
+        Compare, // pop two, push bool
+        Var,     // var x = pop
+        Store    // `type` x = pop
+    };
+
+    struct Node
+    {
+        Op op;
+        Sema::TypeId type = Sema::kNoType;
+    };
+
+    std::vector<Node> Generate(Sema::TypeTable &types, std::size_t statements, std::uint32_t seed)
+    {
+        constexpr Sema::TypeId kFamilies[][3] = {
+                {Sema::kInt8, Sema::kInt32, Sema::kInt64},
+                {Sema::kUint8, Sema::kUint16, Sema::kUint64},
+                {Sema::kFp32, Sema::kFp64, Sema::kFp64},
+        };
+
+        std::mt19937 rng(seed);
+        auto pick = [&](std::uint32_t n) { return static_cast<std::uint32_t>(rng() % n); };
+        std::string error;
+        auto own = [&](Sema::TypeId t, bool is_mut) { return *types.Own(t, is_mut, error); };
+        auto ref = [&](Sema::TypeId t, bool is_mut) { return *types.Ref(t, is_mut, error); };
+
+        std::vector<Node> nodes;
+        for (std::size_t s = 0; s < statements; ++s) {
+            auto const &family = kFamilies[pick(3)];
+            auto const widest = family[2];
+
+            auto leaf = [&] {
+                auto const t = family[pick(3)];
+                switch (pick(6)) {
+                    case 0: return Sema::TypeTable::IsFloat(t) ? Sema::kFloatLiteral : Sema::kIntLiteral;
+                    case 1: return ref(t, pick(2) == 0);
+                    case 2: return own(t, pick(2) == 0);
+                    default: return t;
+                }
+            };
+
+            // A left-leaning chain of 8..23 operators, occasionally ending in a comparison
+            nodes.push_back({Op::Push, leaf()});
+            auto const operators = 8 + pick(16);
+            for (std::uint32_t i = 0; i < operators; ++i) {
+                nodes.push_back({Op::Push, leaf()});
+                nodes.push_back({Op::Arith});
+            }
+
+            switch (pick(4)) {
+                case 0:
+                    nodes.push_back({Op::Push, widest});
+                    nodes.push_back({Op::Compare});
+                    nodes.push_back({Op::Store, Sema::kBool});
+                    break;
+                case 1: nodes.push_back({Op::Var}); break;
+                case 2: nodes.push_back({Op::Store, own(widest, true)}); break;
+                default: nodes.push_back({Op::Store, widest}); break;
+            }
+        }
+        return nodes;
+    }
+
+    struct CheckResult
+    {
+        std::size_t errors = 0;
+        std::size_t conversions = 0;
+    };
+
+    CheckResult CheckInterned(Sema::TypeTable const &types, std::vector<Node> const &nodes)
+    {
+        CheckResult result;
+        std::vector<Sema::TypeId> stack;
+        auto pop = [&] {
+            auto t = stack.back();
+            stack.pop_back();
+            return t;
+        };
+
+        for (auto const &node: nodes) {
+            switch (node.op) {
+                case Op::Push: stack.push_back(node.type); break;
+                case Op::Arith:
+                case Op::Compare: {
+                    auto rhs = pop();
+                    auto lhs = pop();
+                    // Common() propagates kNoType, the check only keeps one error from being counted again
+                    if (lhs == Sema::kNoType || rhs == Sema::kNoType) {
+                        stack.push_back(Sema::kNoType);
+                        break;
+                    }
+                    auto common = types.Common(lhs, rhs);
+                    result.errors += common == Sema::kNoType;
+                    stack.push_back(node.op == Op::Compare && common != Sema::kNoType ? Sema::kBool : common);
+                    break;
+                }
+                case Op::Var: {
+                    auto init = pop();
+                    result.errors += init != Sema::kNoType && Sema::TypeTable::InferVar(init) == Sema::kNoType;
+                    break;
+                }
+                case Op::Store: {
+                    auto value = pop();
+                    if (value == Sema::kNoType) {
+                        break;
+                    }
+                    auto conversion = types.Convert(value, node.type);
+                    result.errors += conversion == Sema::Conversion::Invalid;
+                    result.conversions += conversion != Sema::Conversion::Identity;
+                    break;
+                }
+            }
+        }
+        return result;
+    }
+
+    // The baseline: a type is a tree of nodes naming their primitive, compared structurally
+    struct TreeType
+    {
+        Sema::TypeKind kind;
+        std::string name;
+        bool is_mut = false;
+        std::shared_ptr<TreeType const> element;
+    };
+
+    using TreePtr = std::shared_ptr<TreeType const>;
+
+    bool Same(TreePtr const &a, TreePtr const &b)
+    {
+        if (a == b) {
+            return true;
+        }
+        if (!a || !b || a->kind != b->kind || a->is_mut != b->is_mut || a->name != b->name) {
+            return false;
+        }
+        return a->kind == Sema::TypeKind::Builtin || Same(a->element, b->element);
+    }
+
+    struct TreeChecker
+    {
+        std::vector<TreePtr> by_id; // resolved once per type, as a checker would from its declarations
+
+        explicit TreeChecker(Sema::TypeTable const &types)
+        {
+            for (Sema::TypeId id = 0; id < types.Size(); ++id) {
+                TreeType t{types.Kind(id), "", types.IsMut(id), nullptr};
+                if (t.kind == Sema::TypeKind::Builtin) {
+                    t.name = types.Name(id);
+                }
+                else {
+                    t.element = by_id[types.Element(id)];
+                }
+                by_id.push_back(std::make_shared<TreeType const>(std::move(t)));
+            }
+        }
+
+        TreePtr Value(TreePtr const &t) const { return t->kind == Sema::TypeKind::Builtin ? t : t->element; }
+
+        static bool IsLiteral(TreePtr const &t) { return t->name.ends_with("literal"); }
+        static bool IsFloat(TreePtr const &t) { return t->name == "fp32" || t->name == "fp64"; }
+        static bool IsSigned(TreePtr const &t) { return t->name.starts_with("int"); }
+        static int Width(TreePtr const &t) { return std::atoi(t->name.c_str() + t->name.find_first_of("0123456789")); }
+
+        static bool Widens(TreePtr const &from, TreePtr const &to)
+        {
+            if (from->name == "integer literal") {
+                return to->name != "bool" && (!IsLiteral(to) || to->name == "float literal");
+            }
+            if (from->name == "float literal") {
+                return IsFloat(to);
+            }
+            if (IsLiteral(to) || from->name == "bool" || to->name == "bool" || IsFloat(from) != IsFloat(to)) {
+                return false;
+            }
+            if (IsFloat(from)) {
+                return Width(to) > Width(from);
+            }
+            return Width(to) > Width(from) && (IsSigned(to) || !IsSigned(from));
+        }
+
+        TreePtr Common(TreePtr const &lhs, TreePtr const &rhs) const
+        {
+            auto a = Value(lhs);
+            auto b = Value(rhs);
+            if (Same(a, b)) {
+                return a;
+            }
+            if (a->name == "bool" || b->name == "bool") {
+                return nullptr;
+            }
+            return Widens(a, b) ? b : Widens(b, a) ? a : nullptr;
+        }
+
+        bool Converts(TreePtr const &from, TreePtr const &to) const
+        {
+            if (Same(from, to)) {
+                return true;
+            }
+            if (to->kind == Sema::TypeKind::Own) {
+                auto value = Value(from);
+                return from->kind != Sema::TypeKind::Own &&
+                       (Same(value, to->element) || (IsLiteral(value) && Widens(value, to->element)));
+            }
+            if (to->kind == Sema::TypeKind::Builtin) {
+                return Same(Value(from), to) || (from->kind == Sema::TypeKind::Builtin && Widens(from, to));
+            }
+            return false;
+        }
+    };
+
+    CheckResult CheckTrees(TreeChecker const &checker, std::vector<Node> const &nodes)
+    {
+        CheckResult result;
+        auto const boolean = checker.by_id[Sema::kBool];
+        std::vector<TreePtr> stack;
+        auto pop = [&] {
+            auto t = std::move(stack.back());
+            stack.pop_back();
+            return t;
+        };
+
+        for (auto const &node: nodes) {
+            switch (node.op) {
+                case Op::Push: stack.push_back(checker.by_id[node.type]); break;
+                case Op::Arith:
+                case Op::Compare: {
+                    auto rhs = pop();
+                    auto lhs = pop();
+                    if (!lhs || !rhs) {
+                        stack.emplace_back();
+                        break;
+                    }
+                    auto common = checker.Common(lhs, rhs);
+                    result.errors += !common;
+                    stack.push_back(node.op == Op::Compare && common ? boolean : common);
+                    break;
+                }
+                case Op::Var: {
+                    auto init = pop();
+                    result.errors += init && init->name == "void";
+                    break;
+                }
+                case Op::Store: {
+                    auto value = pop();
+                    if (!value) {
+                        break;
+                    }
+                    auto const &target = checker.by_id[node.type];
+                    result.errors += !checker.Converts(value, target);
+                    result.conversions += !Same(value, target);
+                    break;
+                }
+            }
+        }
+        return result;
+    }
+
+    template<typename F>
+    double Seconds(F f)
+    {
+        auto const start = std::chrono::steady_clock::now();
+        f();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    std::size_t const statements = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2'000'000;
+
+    Sema::TypeTable types;
+    auto const nodes = Generate(types, statements, 42);
+    TreeChecker const trees(types);
+
+    CheckResult interned;
+    CheckResult structural;
+    // Warm up both, then take the faster of three runs each
+    double interned_s = 1e9;
+    double structural_s = 1e9;
+    for (int run = 0; run < 4; ++run) {
+        auto t = Seconds([&] { interned = CheckInterned(types, nodes); });
+        auto u = Seconds([&] { structural = CheckTrees(trees, nodes); });
+        if (run > 0) {
+            interned_s = std::min(interned_s, t);
+            structural_s = std::min(structural_s, u);
+        }
+    }
+
+    std::cout << statements << " statements, " << nodes.size() << " nodes, " << types.Size() << " types, "
+              << interned.errors << " type errors, " << interned.conversions << " implicit conversions\n";
+    if (interned.errors != structural.errors || interned.conversions != structural.conversions) {
+        std::cerr << "error: checkers disagree (" << structural.errors << " errors, " << structural.conversions
+                  << " conversions)\n";
+        return 1;
+    }
+
+    auto report = [&](std::string_view name, double seconds) {
+        std::cout << std::left << std::setw(12) << name << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(10) << seconds * 1e3 << " ms" << std::setw(10) << nodes.size() / seconds / 1e6
+                  << " Mnodes/s\n";
+    };
+    report("interned", interned_s);
+    report("structural", structural_s);
+    return 0;
+}
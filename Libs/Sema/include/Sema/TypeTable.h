@@ -0,0 +1,114 @@
+#pragma once
+#include <Lexer/Types.h>
+
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Sema
+{
+
+    using TypeId = std::uint32_t;
+
+    constexpr TypeId kNoType = UINT32_MAX;
+
+    // Built-in types have fixed ids, in the same order as their type keywords, so they can be used as constants.
+    // The literal types are the types of untyped integer and float literals before they meet a concrete type.
+    constexpr TypeId kVoid = 0;
+    constexpr TypeId kBool = 1;
+    constexpr TypeId kInt8 = 2;
+    constexpr TypeId kInt16 = 3;
+    constexpr TypeId kInt32 = 4;
+    constexpr TypeId kInt64 = 5;
+    constexpr TypeId kUint8 = 6;
+    constexpr TypeId kUint16 = 7;
+    constexpr TypeId kUint32 = 8;
+    constexpr TypeId kUint64 = 9;
+    constexpr TypeId kFp32 = 10;
+    constexpr TypeId kFp64 = 11;
+    constexpr TypeId kIntLiteral = 12;
+    constexpr TypeId kFloatLiteral = 13;
+    constexpr TypeId kNumBuiltinTypes = 14;
+
+    enum class TypeKind : std::uint8_t
+    {
+        Builtin,
+        Own, // Own<T> or Own<mut T>
+        Ref  // Ref<T> or Ref<mut T>
+    };
+
+    // How a value of one type becomes a value of another
+    enum class Conversion : std::uint8_t
+    {
+        Invalid,
+        Identity,
+        Literal,   // untyped literal takes on a concrete type
+        Widen,     // lossless numeric widening
+        Reborrow,  // Ref<mut T> -> Ref<T>
+        Borrow,    // T, Own<T>, Own<mut T> -> Ref<T>
+        BorrowMut, // T, Own<mut T> -> Ref<mut T>; a plain T must also be a mutable binding
+        Copy,      // auto-deref read: Own<T>, Ref<T>, Ref<mut T> -> T
+        Alloc      // T, Ref<T> -> Own<T>, copying the value into a new owner
+    };
+
+    std::ostream &operator<<(std::ostream &os, Conversion conversion);
+
+    // Hash-consed table of every type used while checking a compilation. Each distinct type is stored once and
+    // named by a dense 32-bit id, so type equality is an id compare, and the per-type data lives in a few parallel
+    // arrays indexed by id. Queries expect ids handed out by the same table.
+    class TypeTable
+    {
+    public:
+        TypeTable();
+
+        // Returns the id of Own<element> / Ref<element>, creating it on first use. Owners and references can only
+        // wrap plain values, so a nested owner or reference (and void) is rejected with `error` set.
+        std::optional<TypeId> Own(TypeId element, bool is_mut, std::string &error);
+        std::optional<TypeId> Ref(TypeId element, bool is_mut, std::string &error);
+
+        [[nodiscard]] static std::optional<TypeId> FromToken(Lexer::TokenKind kind);
+
+        [[nodiscard]] TypeKind Kind(TypeId type) const { return kinds_[type]; }
+        [[nodiscard]] TypeId Element(TypeId type) const { return elements_[type]; }
+        [[nodiscard]] bool IsMut(TypeId type) const { return is_mut_[type] != 0; }
+        [[nodiscard]] std::size_t Size() const { return kinds_.size(); }
+
+        [[nodiscard]] static constexpr bool IsInteger(TypeId type) { return type >= kInt8 && type <= kUint64; }
+        [[nodiscard]] static constexpr bool IsFloat(TypeId type) { return type == kFp32 || type == kFp64; }
+        [[nodiscard]] static constexpr bool IsNumeric(TypeId type)
+        {
+            return IsInteger(type) || IsFloat(type) || type == kIntLiteral || type == kFloatLiteral;
+        }
+
+        // Implicit conversion from `from` to `to`, for assignments, arguments and returns. Invalid if either is
+        // kNoType or not a type of this table.
+        [[nodiscard]] Conversion Convert(TypeId from, TypeId to) const;
+
+        // The type a value is read as: the element of owners and references, the type itself otherwise. kNoType for
+        // kNoType and ids that are not in the table.
+        [[nodiscard]] TypeId ValueType(TypeId type) const { return type < Size() ? value_types_[type] : kNoType; }
+
+        // Type both operands of an arithmetic or comparison operator are converted to (after auto-deref), or
+        // kNoType if they have none or either operand is kNoType. Literals take on the type of the other operand.
+        [[nodiscard]] TypeId Common(TypeId lhs, TypeId rhs) const;
+
+        // Type of `var x = init;`: literals become int32 or fp64, a void initializer gives kNoType.
+        [[nodiscard]] static TypeId InferVar(TypeId init);
+
+        [[nodiscard]] std::string Name(TypeId type) const;
+
+    private:
+        std::vector<TypeKind> kinds_;
+        std::vector<TypeId> elements_;
+        std::vector<std::uint8_t> is_mut_;
+        std::vector<TypeId> value_types_;
+        std::unordered_map<std::uint64_t, TypeId> ids_;
+
+        [[nodiscard]] bool IsPlainValue_(TypeId type) const;
+        TypeId Intern_(TypeKind kind, TypeId element, bool is_mut);
+    };
+
+} // namespace Sema
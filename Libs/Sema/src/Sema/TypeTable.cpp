@@ -0,0 +1,266 @@
+#include <Sema/TypeTable.h>
+
+#include <array>
+#include <string_view>
+
+namespace Sema
+{
+
+    namespace Detail
+    {
+        constexpr std::size_t kBuiltinPairs = kNumBuiltinTypes * kNumBuiltinTypes;
+
+        constexpr int Width(TypeId type)
+        {
+            switch (type) {
+                case kInt8:
+                case kUint8: return 8;
+                case kInt16:
+                case kUint16: return 16;
+                case kInt32:
+                case kUint32:
+                case kFp32: return 32;
+                default: return 64;
+            }
+        }
+
+        constexpr bool IsSigned(TypeId type) { return type >= kInt8 && type <= kInt64; }
+
+        constexpr Conversion ConvertBuiltin(TypeId from, TypeId to)
+        {
+            if (from == to) {
+                return Conversion::Identity;
+            }
+            if (from == kIntLiteral && TypeTable::IsNumeric(to)) {
+                return Conversion::Literal;
+            }
+            if (from == kFloatLiteral && TypeTable::IsFloat(to)) {
+                return Conversion::Literal;
+            }
+            if (TypeTable::IsInteger(from) && TypeTable::IsInteger(to)) {
+                // Never to a narrower type, and never from signed to unsigned
+                bool const wider = Width(to) > Width(from);
+                return wider && (IsSigned(to) || !IsSigned(from)) ? Conversion::Widen : Conversion::Invalid;
+            }
+            return from == kFp32 && to == kFp64 ? Conversion::Widen : Conversion::Invalid;
+        }
+
+        constexpr TypeId CommonBuiltin(TypeId lhs, TypeId rhs)
+        {
+            if (lhs == kVoid || rhs == kVoid) {
+                return kNoType;
+            }
+            if (lhs == rhs) {
+                return lhs;
+            }
+            auto const to_rhs = ConvertBuiltin(lhs, rhs);
+            if (to_rhs == Conversion::Literal || to_rhs == Conversion::Widen) {
+                return rhs;
+            }
+            auto const to_lhs = ConvertBuiltin(rhs, lhs);
+            if (to_lhs == Conversion::Literal || to_lhs == Conversion::Widen) {
+                return lhs;
+            }
+            return kNoType;
+        }
+
+        // Everything about two built-in types is precomputed, so checks on them are a single load
+        template<typename T, typename F>
+        constexpr std::array<T, kBuiltinPairs> PairTable(F f)
+        {
+            std::array<T, kBuiltinPairs> table{};
+            for (TypeId from = 0; from < kNumBuiltinTypes; ++from) {
+                for (TypeId to = 0; to < kNumBuiltinTypes; ++to) {
+                    table[from * kNumBuiltinTypes + to] = f(from, to);
+                }
+            }
+            return table;
+        }
+
+        constexpr auto kBuiltinConversions = PairTable<Conversion>(ConvertBuiltin);
+        constexpr auto kBuiltinCommon = PairTable<TypeId>(CommonBuiltin);
+
+        static_assert(kBuiltinConversions[kInt8 * kNumBuiltinTypes + kInt64] == Conversion::Widen);
+        static_assert(kBuiltinConversions[kInt8 * kNumBuiltinTypes + kUint64] == Conversion::Invalid);
+        static_assert(kBuiltinCommon[kIntLiteral * kNumBuiltinTypes + kFp32] == kFp32);
+
+        constexpr std::array<std::string_view, kNumBuiltinTypes> kBuiltinNames{
+                "void",   "bool",   "int8", "int16", "int32",           "int64",        "uint8",
+                "uint16", "uint32", "uint64", "fp32", "fp64", "integer literal", "float literal",
+        };
+
+        constexpr std::uint64_t Key(TypeKind kind, TypeId element, bool is_mut)
+        {
+            return static_cast<std::uint64_t>(element) << 8 | static_cast<std::uint64_t>(kind) << 1 |
+                   static_cast<std::uint64_t>(is_mut);
+        }
+    } // namespace Detail
+
+    std::ostream &operator<<(std::ostream &os, Conversion conversion)
+    {
+        switch (conversion) {
+            case Conversion::Invalid: return os << "Invalid";
+            case Conversion::Identity: return os << "Identity";
+            case Conversion::Literal: return os << "Literal";
+            case Conversion::Widen: return os << "Widen";
+            case Conversion::Reborrow: return os << "Reborrow";
+            case Conversion::Borrow: return os << "Borrow";
+            case Conversion::BorrowMut: return os << "BorrowMut";
+            case Conversion::Copy: return os << "Copy";
+            case Conversion::Alloc: return os << "Alloc";
+        }
+        return os << "Unknown";
+    }
+
+    TypeTable::TypeTable()
+    {
+        for (TypeId type = 0; type < kNumBuiltinTypes; ++type) {
+            kinds_.push_back(TypeKind::Builtin);
+            elements_.push_back(kNoType);
+            is_mut_.push_back(0);
+            value_types_.push_back(type);
+        }
+    }
+
+    bool TypeTable::IsPlainValue_(TypeId type) const
+    {
+        return type < Size() && Kind(type) == TypeKind::Builtin && type != kVoid && type != kIntLiteral &&
+               type != kFloatLiteral;
+    }
+
+    TypeId TypeTable::Intern_(TypeKind kind, TypeId element, bool is_mut)
+    {
+        auto [it, inserted] = ids_.try_emplace(Detail::Key(kind, element, is_mut), static_cast<TypeId>(Size()));
+        if (inserted) {
+            kinds_.push_back(kind);
+            elements_.push_back(element);
+            is_mut_.push_back(is_mut ? 1 : 0);
+            value_types_.push_back(element);
+        }
+        return it->second;
+    }
+
+    std::optional<TypeId> TypeTable::Own(TypeId element, bool is_mut, std::string &error)
+    {
+        if (!IsPlainValue_(element)) {
+            error = "cannot make an owner of " + Name(element) + ": owners hold plain values";
+            return std::nullopt;
+        }
+        return Intern_(TypeKind::Own, element, is_mut);
+    }
+
+    std::optional<TypeId> TypeTable::Ref(TypeId element, bool is_mut, std::string &error)
+    {
+        if (!IsPlainValue_(element)) {
+            error = "cannot make a reference to " + Name(element) + ": borrow the underlying value instead";
+            return std::nullopt;
+        }
+        return Intern_(TypeKind::Ref, element, is_mut);
+    }
+
+    std::optional<TypeId> TypeTable::FromToken(Lexer::TokenKind kind)
+    {
+        if (kind < Lexer::TokenKind::Void || kind > Lexer::TokenKind::Fp64) {
+            return std::nullopt;
+        }
+        // Type keywords are declared in the order of the built-in ids
+        static_assert(static_cast<int>(Lexer::TokenKind::Fp64) - static_cast<int>(Lexer::TokenKind::Void) == kFp64);
+        static_assert(static_cast<int>(Lexer::TokenKind::Int8) - static_cast<int>(Lexer::TokenKind::Void) == kInt8);
+        static_assert(static_cast<int>(Lexer::TokenKind::Uint8) - static_cast<int>(Lexer::TokenKind::Void) == kUint8);
+        static_assert(kNumBuiltinTypes == kFp64 + 3, "only the two literal types follow the type keywords");
+        return static_cast<TypeId>(static_cast<int>(kind) - static_cast<int>(Lexer::TokenKind::Void));
+    }
+
+    Conversion TypeTable::Convert(TypeId from, TypeId to) const
+    {
+        if (from < kNumBuiltinTypes && to < kNumBuiltinTypes) {
+            return Detail::kBuiltinConversions[from * kNumBuiltinTypes + to];
+        }
+        if (from >= Size() || to >= Size()) {
+            return Conversion::Invalid; // also covers kNoType
+        }
+        if (from == to) {
+            return Conversion::Identity;
+        }
+
+        auto const from_kind = Kind(from);
+        switch (Kind(to)) {
+            case TypeKind::Builtin:
+                return from_kind != TypeKind::Builtin && Element(from) == to ? Conversion::Copy : Conversion::Invalid;
+            case TypeKind::Ref: {
+                auto const element = Element(to);
+                auto const to_mut = IsMut(to);
+                if (from_kind == TypeKind::Builtin) {
+                    if (from != element) {
+                        return Conversion::Invalid;
+                    }
+                    return to_mut ? Conversion::BorrowMut : Conversion::Borrow;
+                }
+                if (Element(from) != element) {
+                    return Conversion::Invalid;
+                }
+                if (from_kind == TypeKind::Ref) {
+                    // Only a mutable reference differs from `to`, as equal types have the same id
+                    return to_mut ? Conversion::Invalid : Conversion::Reborrow;
+                }
+                if (!to_mut) {
+                    return Conversion::Borrow;
+                }
+                return IsMut(from) ? Conversion::BorrowMut : Conversion::Invalid;
+            }
+            case TypeKind::Own: {
+                auto const element = Element(to);
+                if (from_kind == TypeKind::Builtin) {
+                    auto const conversion = Convert(from, element);
+                    bool const fits = conversion == Conversion::Identity || conversion == Conversion::Literal;
+                    return fits ? Conversion::Alloc : Conversion::Invalid;
+                }
+                // Owners are moved, not copied into a new owner
+                return from_kind == TypeKind::Ref && Element(from) == element ? Conversion::Alloc : Conversion::Invalid;
+            }
+        }
+        return Conversion::Invalid;
+    }
+
+    TypeId TypeTable::Common(TypeId lhs, TypeId rhs) const
+    {
+        auto const lhs_value = ValueType(lhs);
+        auto const rhs_value = ValueType(rhs);
+        if (lhs_value == kNoType || rhs_value == kNoType) {
+            return kNoType;
+        }
+        if (lhs_value < kNumBuiltinTypes && rhs_value < kNumBuiltinTypes) {
+            return Detail::kBuiltinCommon[lhs_value * kNumBuiltinTypes + rhs_value];
+        }
+        return lhs_value == rhs_value ? lhs_value : kNoType;
+    }
+
+    TypeId TypeTable::InferVar(TypeId init)
+    {
+        switch (init) {
+            case kVoid: return kNoType;
+            case kIntLiteral: return kInt32;
+            case kFloatLiteral: return kFp64;
+            default: return init;
+        }
+    }
+
+    std::string TypeTable::Name(TypeId type) const
+    {
+        if (type == kNoType) {
+            return "<no type>";
+        }
+        if (type >= Size()) {
+            return "<unknown type " + std::to_string(type) + ">";
+        }
+        if (Kind(type) == TypeKind::Builtin) {
+            return std::string(Detail::kBuiltinNames[type]);
+        }
+        std::string name = Kind(type) == TypeKind::Own ? "Own<" : "Ref<";
+        if (IsMut(type)) {
+            name += "mut ";
+        }
+        return name + Name(Element(type)) + ">";
+    }
+
+} // namespace Sema
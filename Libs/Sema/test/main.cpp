@@ -0,0 +1,187 @@
+#include <Sema/TypeTable.h>
+#include <gtest/gtest.h>
+
+using Sema::Conversion;
+
+namespace
+{
+    Sema::TypeId Own(Sema::TypeTable &types, Sema::TypeId element, bool is_mut = false)
+    {
+        std::string error;
+        auto type = types.Own(element, is_mut, error);
+        EXPECT_TRUE(type) << error;
+        return type.value_or(Sema::kNoType);
+    }
+
+    Sema::TypeId Ref(Sema::TypeTable &types, Sema::TypeId element, bool is_mut = false)
+    {
+        std::string error;
+        auto type = types.Ref(element, is_mut, error);
+        EXPECT_TRUE(type) << error;
+        return type.value_or(Sema::kNoType);
+    }
+} // namespace
+
+//
+// Interning
+//
+TEST(TypeTableInterning, BuiltinsHaveFixedIds)
+{
+    Sema::TypeTable types;
+    EXPECT_EQ(types.Size(), Sema::kNumBuiltinTypes);
+    EXPECT_EQ(Sema::TypeTable::FromToken(Lexer::TokenKind::Void), Sema::kVoid);
+    EXPECT_EQ(Sema::TypeTable::FromToken(Lexer::TokenKind::Int32), Sema::kInt32);
+    EXPECT_EQ(Sema::TypeTable::FromToken(Lexer::TokenKind::Uint8), Sema::kUint8);
+    EXPECT_EQ(Sema::TypeTable::FromToken(Lexer::TokenKind::Fp64), Sema::kFp64);
+    EXPECT_FALSE(Sema::TypeTable::FromToken(Lexer::TokenKind::Ident));
+    EXPECT_EQ(types.Name(Sema::kUint16), "uint16");
+}
+
+TEST(TypeTableInterning, ConstructedTypesAreDeduplicated)
+{
+    Sema::TypeTable types;
+    auto own = Own(types, Sema::kInt32);
+    auto own_mut = Own(types, Sema::kInt32, true);
+    auto ref = Ref(types, Sema::kInt32);
+    auto ref_mut = Ref(types, Sema::kInt32, true);
+
+    EXPECT_EQ(Own(types, Sema::kInt32), own);
+    EXPECT_EQ(Ref(types, Sema::kInt32, true), ref_mut);
+    EXPECT_NE(own, own_mut);
+    EXPECT_NE(own, ref);
+    EXPECT_NE(ref, ref_mut);
+    EXPECT_NE(Own(types, Sema::kInt64), own);
+    EXPECT_EQ(types.Size(), Sema::kNumBuiltinTypes + 5);
+
+    EXPECT_EQ(types.Kind(ref_mut), Sema::TypeKind::Ref);
+    EXPECT_EQ(types.Element(ref_mut), Sema::kInt32);
+    EXPECT_TRUE(types.IsMut(ref_mut));
+    EXPECT_EQ(types.Name(own_mut), "Own<mut int32>");
+    EXPECT_EQ(types.Name(ref), "Ref<int32>");
+}
+
+TEST(TypeTableInterning, RejectsNestedOwnersAndReferences)
+{
+    Sema::TypeTable types;
+    auto own = Own(types, Sema::kFp64);
+    auto ref = Ref(types, Sema::kFp64);
+
+    std::string error;
+    EXPECT_FALSE(types.Ref(own, false, error));
+    EXPECT_EQ(error, "cannot make a reference to Own<fp64>: borrow the underlying value instead");
+    EXPECT_FALSE(types.Own(ref, false, error));
+    EXPECT_FALSE(types.Own(Sema::kVoid, true, error));
+    EXPECT_FALSE(types.Ref(Sema::kIntLiteral, false, error));
+    EXPECT_FALSE(types.Ref(Sema::kNoType, false, error));
+}
+
+TEST(TypeTableInterning, RejectsUnknownIds)
+{
+    Sema::TypeTable types;
+    std::string error;
+    EXPECT_FALSE(types.Own(1000, false, error));
+    EXPECT_EQ(error, "cannot make an owner of <unknown type 1000>: owners hold plain values");
+    EXPECT_FALSE(types.Ref(types.Size(), true, error));
+    EXPECT_EQ(types.Name(types.Size()), "<unknown type 14>");
+}
+
+//
+// Conversions
+//
+TEST(TypeTableConversions, Builtins)
+{
+    Sema::TypeTable types;
+    EXPECT_EQ(types.Convert(Sema::kInt32, Sema::kInt32), Conversion::Identity);
+    EXPECT_EQ(types.Convert(Sema::kInt8, Sema::kInt64), Conversion::Widen);
+    EXPECT_EQ(types.Convert(Sema::kUint8, Sema::kInt16), Conversion::Widen);
+    EXPECT_EQ(types.Convert(Sema::kFp32, Sema::kFp64), Conversion::Widen);
+    EXPECT_EQ(types.Convert(Sema::kInt64, Sema::kInt32), Conversion::Invalid);
+    EXPECT_EQ(types.Convert(Sema::kInt8, Sema::kUint64), Conversion::Invalid);
+    EXPECT_EQ(types.Convert(Sema::kUint32, Sema::kInt32), Conversion::Invalid);
+    EXPECT_EQ(types.Convert(Sema::kInt32, Sema::kFp64), Conversion::Invalid);
+    EXPECT_EQ(types.Convert(Sema::kBool, Sema::kInt32), Conversion::Invalid);
+    EXPECT_EQ(types.Convert(Sema::kIntLiteral, Sema::kUint8), Conversion::Literal);
+    EXPECT_EQ(types.Convert(Sema::kIntLiteral, Sema::kFp32), Conversion::Literal);
+    EXPECT_EQ(types.Convert(Sema::kFloatLiteral, Sema::kFp32), Conversion::Literal);
+    EXPECT_EQ(types.Convert(Sema::kFloatLiteral, Sema::kInt64), Conversion::Invalid);
+}
+
+TEST(TypeTableConversions, OwnersAndReferences)
+{
+    Sema::TypeTable types;
+    auto own = Own(types, Sema::kInt32);
+    auto own_mut = Own(types, Sema::kInt32, true);
+    auto ref = Ref(types, Sema::kInt32);
+    auto ref_mut = Ref(types, Sema::kInt32, true);
+
+    EXPECT_EQ(types.Convert(Sema::kInt32, own), Conversion::Alloc);
+    EXPECT_EQ(types.Convert(Sema::kIntLiteral, own_mut), Conversion::Alloc);
+    EXPECT_EQ(types.Convert(ref, own), Conversion::Alloc);
+    EXPECT_EQ(types.Convert(own, own), Conversion::Identity);
+    EXPECT_EQ(types.Convert(own_mut, own), Conversion::Invalid);
+    EXPECT_EQ(types.Convert(Sema::kInt8, own), Conversion::Invalid);
+
+    EXPECT_EQ(types.Convert(own, Sema::kInt32), Conversion::Copy);
+    EXPECT_EQ(types.Convert(ref_mut, Sema::kInt32), Conversion::Copy);
+    EXPECT_EQ(types.Convert(ref, Sema::kInt64), Conversion::Invalid);
+
+    EXPECT_EQ(types.Convert(Sema::kInt32, ref), Conversion::Borrow);
+    EXPECT_EQ(types.Convert(Sema::kInt32, ref_mut), Conversion::BorrowMut);
+    EXPECT_EQ(types.Convert(own, ref), Conversion::Borrow);
+    EXPECT_EQ(types.Convert(own, ref_mut), Conversion::Invalid);
+    EXPECT_EQ(types.Convert(own_mut, ref_mut), Conversion::BorrowMut);
+    EXPECT_EQ(types.Convert(ref_mut, ref), Conversion::Reborrow);
+    EXPECT_EQ(types.Convert(ref, ref_mut), Conversion::Invalid);
+    EXPECT_EQ(types.Convert(Ref(types, Sema::kInt64), ref), Conversion::Invalid);
+}
+
+//
+// Operators and inference
+//
+TEST(TypeTableOperators, CommonType)
+{
+    Sema::TypeTable types;
+    EXPECT_EQ(types.Common(Sema::kInt32, Sema::kInt32), Sema::kInt32);
+    EXPECT_EQ(types.Common(Sema::kInt8, Sema::kInt32), Sema::kInt32);
+    EXPECT_EQ(types.Common(Sema::kIntLiteral, Sema::kUint16), Sema::kUint16);
+    EXPECT_EQ(types.Common(Sema::kIntLiteral, Sema::kFloatLiteral), Sema::kFloatLiteral);
+    EXPECT_EQ(types.Common(Sema::kFp32, Sema::kFp64), Sema::kFp64);
+    EXPECT_EQ(types.Common(Sema::kInt32, Sema::kUint32), Sema::kNoType);
+    EXPECT_EQ(types.Common(Sema::kInt32, Sema::kFp64), Sema::kNoType);
+    EXPECT_EQ(types.Common(Sema::kVoid, Sema::kVoid), Sema::kNoType);
+
+    // Operands are read through owners and references
+    EXPECT_EQ(types.Common(Ref(types, Sema::kInt16), Own(types, Sema::kInt64)), Sema::kInt64);
+    EXPECT_EQ(types.Common(Ref(types, Sema::kFp32, true), Sema::kFloatLiteral), Sema::kFp32);
+}
+
+TEST(TypeTableOperators, MissingAndUnknownTypes)
+{
+    Sema::TypeTable types;
+    auto own = Own(types, Sema::kInt32);
+    auto const unknown = static_cast<Sema::TypeId>(types.Size());
+
+    // Results of failed checks feed into enclosing expressions
+    EXPECT_EQ(types.Common(types.Common(Sema::kBool, Sema::kInt32), Sema::kInt32), Sema::kNoType);
+    EXPECT_EQ(types.Common(Sema::kNoType, Sema::kNoType), Sema::kNoType);
+    EXPECT_EQ(types.Common(own, unknown), Sema::kNoType);
+    EXPECT_EQ(types.Common(1000, Sema::kInt32), Sema::kNoType);
+    EXPECT_EQ(types.ValueType(Sema::kNoType), Sema::kNoType);
+
+    EXPECT_EQ(types.Convert(Sema::kNoType, Sema::kInt32), Sema::Conversion::Invalid);
+    EXPECT_EQ(types.Convert(Sema::kInt32, Sema::kNoType), Sema::Conversion::Invalid);
+    EXPECT_EQ(types.Convert(Sema::kNoType, Sema::kNoType), Sema::Conversion::Invalid);
+    EXPECT_EQ(types.Convert(own, unknown), Sema::Conversion::Invalid);
+    EXPECT_EQ(types.Convert(unknown, own), Sema::Conversion::Invalid);
+}
+
+TEST(TypeTableOperators, InferVar)
+{
+    Sema::TypeTable types;
+    auto ref = Ref(types, Sema::kBool);
+    EXPECT_EQ(Sema::TypeTable::InferVar(Sema::kIntLiteral), Sema::kInt32);
+    EXPECT_EQ(Sema::TypeTable::InferVar(Sema::kFloatLiteral), Sema::kFp64);
+    EXPECT_EQ(Sema::TypeTable::InferVar(Sema::kUint8), Sema::kUint8);
+    EXPECT_EQ(Sema::TypeTable::InferVar(ref), ref);
+    EXPECT_EQ(Sema::TypeTable::InferVar(Sema::kVoid), Sema::kNoType);
+}
@@ -1 +1,156 @@
-int main(int argc, char **argv) { return 0; }
+#include <Driver/Compiler.h>
+#include <Driver/Server.h>
+
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+
+    struct Options
+    {
+        std::string command = "check";
+        bool alloc_stats = false;
+        bool use_interfaces = true;
+        bool timing = false;
+        bool use_daemon = false;
+        std::filesystem::path socket = Driver::DefaultSocketPath();
+        std::vector<std::filesystem::path> paths;
+    };
+
+    void PrintUsage(std::ostream &os)
+    {
+        os << "usage: WaffleCompiler [check|build] [--alloc-stats] [--no-interfaces] [--timing]\n"
+              "                      [--daemon [--socket <path>]] <path>...\n"
+              "       WaffleCompiler serve [--socket <path>]\n"
+              "       WaffleCompiler shutdown [--socket <path>]\n";
+    }
+
+    // Prints everything but the summary line, which is only shown with --timing. Returns whether it reported ok.
+    bool Report(std::string_view response, bool timing)
+    {
+        auto status = response.rfind("status ");
+        if (status == std::string_view::npos) {
+            std::cerr << response;
+            return false;
+        }
+
+        std::cerr << response.substr(0, status);
+        if (timing) {
+            std::cerr << response.substr(status);
+        }
+        return response.substr(status).starts_with("status ok");
+    }
+
+    int Serve(Options const &options)
+    {
+        Driver::Server server(options.socket, Driver::ParseSearchPath(std::getenv("WAFFLE_PATH")));
+        std::string error;
+        if (!server.Listen(error)) {
+            std::cerr << "error: " << error << "\n";
+            return 1;
+        }
+        std::cerr << "listening on " << options.socket.string() << "\n";
+        server.Serve();
+        return 0;
+    }
+
+    int RunRemote(Options const &options)
+    {
+        bool ok = true;
+        auto send = [&](std::string const &command, std::vector<std::string> args) {
+            std::string error;
+            auto response = Driver::SendRequest(options.socket, Driver::EncodeRequest(command, args), error);
+            if (!response) {
+                std::cerr << "error: " << error << "\n";
+                ok = false;
+                return;
+            }
+            ok = Report(*response, options.timing) && ok;
+        };
+
+        if (options.command == "shutdown") {
+            send(options.command, {});
+        }
+        for (auto const &path: options.paths) {
+            std::vector<std::string> args;
+            if (options.alloc_stats) {
+                args.emplace_back("--alloc-stats");
+            }
+            if (!options.use_interfaces) {
+                args.emplace_back("--no-interfaces");
+            }
+            // The server may run in another working directory
+            args.push_back(std::filesystem::absolute(path).string());
+            send(options.command, std::move(args));
+        }
+        return ok ? 0 : 1;
+    }
+
+    int RunLocal(Options const &options)
+    {
+        Driver::Compiler compiler(Driver::ParseSearchPath(std::getenv("WAFFLE_PATH")));
+        Driver::RunOptions run_options;
+        run_options.command = options.command == "build" ? Driver::Command::Build : Driver::Command::Check;
+        run_options.alloc_stats = options.alloc_stats;
+        run_options.use_interfaces = options.use_interfaces;
+
+        bool ok = true;
+        for (auto const &path: options.paths) {
+            ok = Report(Driver::FormatResult(compiler.Run(path, run_options)), options.timing) && ok;
+        }
+        return ok ? 0 : 1;
+    }
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    Options options;
+    auto args = std::span(argv + 1, argc - 1);
+    for (std::size_t i = 0; i < args.size(); ++i) {
+        std::string_view arg = args[i];
+        if (i == 0 && (arg == "check" || arg == "build" || arg == "serve" || arg == "shutdown")) {
+            options.command = arg;
+        }
+        else if (arg == "--alloc-stats") {
+            options.alloc_stats = true;
+        }
+        else if (arg == "--no-interfaces") {
+            options.use_interfaces = false;
+        }
+        else if (arg == "--timing") {
+            options.timing = true;
+        }
+        else if (arg == "--daemon") {
+            options.use_daemon = true;
+        }
+        else if (arg == "--socket" && i + 1 < args.size()) {
+            options.socket = args[++i];
+        }
+        else if (arg == "--help" || arg == "-h") {
+            PrintUsage(std::cout);
+            return 0;
+        }
+        else {
+            options.paths.emplace_back(arg);
+        }
+    }
+
+    if (options.command == "serve") {
+        return Serve(options);
+    }
+    if (options.command == "shutdown") {
+        return RunRemote(options);
+    }
+    if (options.paths.empty()) {
+        PrintUsage(std::cerr);
+        return 1;
+    }
+    return options.use_daemon ? RunRemote(options) : RunLocal(options);
+}